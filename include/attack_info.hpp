@@ -0,0 +1,34 @@
+#pragma once
+#include "position.hpp"
+
+namespace chess {
+
+// Full attack maps for both colors, by piece type, built in one pass over the board instead of one
+// lookup per square. Sliders are expanded set-wise with Kogge-Stone occluded fills: every slider set of
+// both colors is pushed along one direction at a time, four bitboards per AVX2 register (two per SSE2
+// register). A color's sliders see through the enemy king, so a square behind the king on a checking
+// ray counts as attacked; that is the set a king step must avoid.
+struct AttackInfo {
+  AttackInfo() = default;
+  explicit AttackInfo(const Position &pos);
+
+  U64 by_type[2][6] = {};   // [Color][PieceType]: squares attacked by that color's pieces of that type
+  U64 all[2] = {};          // squares attacked by at least one piece of the color
+
+  U64 attacked_by(Color c, PieceType pt) const { return by_type[c][pt]; }
+};
+
+// Slider fill implementation. The default follows cpu_features(); the others stay callable for tests
+// and benchmarks. Kernels the host or build cannot run fall back to the next narrower one.
+enum FillKernel : int { FILL_SCALAR, FILL_SSE2, FILL_AVX2 };
+
+FillKernel default_fill_kernel();
+void compute_attack_info(const Position &pos, AttackInfo &info, FillKernel kernel);
+
+// Attack maps of pos through a small per-thread cache keyed by the Zobrist key, so consumers that need
+// the full maps at the same node share one computation. Move generation does not use it: a king step
+// or castling path checks only a few squares, and per-square attackers_to is cheaper than both maps.
+// The reference is only valid until the next call on this thread.
+const AttackInfo &attack_info(const Position &pos);
+
+} // namespace chess
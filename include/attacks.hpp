@@ -1,27 +1,57 @@
 #pragma once
 #include "position.hpp"
-#include <mutex>
+#include "cpu.hpp"
+#include <array>
 
 namespace chess {
 
+// Board geometry masks (a1 = bit 0, h8 = bit 63).
+inline constexpr U64 FILE_A = 0x0101010101010101ULL;
+inline constexpr U64 FILE_H = 0x8080808080808080ULL;
+inline constexpr U64 RANK_1 = 0x00000000000000FFULL;
+inline constexpr U64 RANK_3 = 0x0000000000FF0000ULL;
+inline constexpr U64 RANK_6 = 0x0000FF0000000000ULL;
+inline constexpr U64 RANK_8 = 0xFF00000000000000ULL;
+
 // Pre-computed attack bitboards for knights and kings at each square (0..63).
-extern U64 knight_attacks[64];
-extern U64 king_attacks[64];
-
-// Initialize attack tables (call once at startup).
-void init_attack_tables();
-
-// RAII initializer for attack tables - ensures initialization happens exactly once
-class AttackTablesInitializer {
-private:
-    static std::once_flag init_flag_;
-    
-public:
-    AttackTablesInitializer() {
-        std::call_once(init_flag_, []() {
-            init_attack_tables();
-        });
-    }
+// All tables in this header are generated at compile time (see attacks.cpp).
+extern const std::array<U64, 64> knight_attacks;
+extern const std::array<U64, 64> king_attacks;
+
+// Squares attacked by a pawn of the given color standing on each square.
+extern const std::array<std::array<U64, 64>, 2> pawn_attacks;
+
+// Squares strictly between two squares, and the whole board-edge-to-edge line through them (both ends
+// included). Empty when the squares are not on a common rank, file or diagonal.
+extern const std::array<std::array<U64, 64>, 64> between_bb;
+extern const std::array<std::array<U64, 64>, 64> line_bb;
+
+// Magic bitboard entry for one slider on one square.
+// The attack set for an occupancy is attacks[((occ & mask) * magic) >> shift]. On BMI2 hosts the
+// same set is read from pext_attacks[pext(occ, mask)], a second table laid out for that index.
+struct Magic {
+  U64 mask;                        // relevant occupancy: the piece's rays without the board edge squares
+  U64 magic;                       // multiplier that maps every subset of mask to a collision-free index
+  const U64 *attacks;              // this square's slice of the magic-indexed table
+  const U64 *pext_attacks;         // this square's slice of the pext-indexed table (x86-64 only)
+  int shift;                       // 64 - popcount(mask)
+
+  U64 lookup(U64 occ) const {
+#if defined(__BMI2__)
+    return pext_attacks[pext(occ, mask)];
+#else
+    if (use_pext_sliders) return pext_attacks[pext(occ, mask)];
+    return attacks[((occ & mask) * magic) >> shift];
+#endif
+  }
 };
 
+extern const std::array<Magic, 64> bishop_magics;
+extern const std::array<Magic, 64> rook_magics;
+
+// Slider attacks from sq given the board occupancy (includes the first blocker on each ray).
+inline U64 bishop_attacks(int sq, U64 occ) { return bishop_magics[sq].lookup(occ); }
+inline U64 rook_attacks(int sq, U64 occ) { return rook_magics[sq].lookup(occ); }
+inline U64 queen_attacks(int sq, U64 occ) { return bishop_attacks(sq, occ) | rook_attacks(sq, occ); }
+
 } // namespace chess
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#if defined(__BMI2__) || defined(__POPCNT__)
+#include <immintrin.h>
+#endif
+
+namespace chess {
+
+// CPU features relevant to the bitboard kernels, detected once at startup (CPUID).
+struct CpuFeatures {
+  bool popcnt = false;
+  bool bmi2 = false;
+  bool fast_pext = false; // BMI2 present and PEXT not microcoded (AMD Zen 1/2 run it in ~18 uops)
+  bool avx2 = false;
+};
+
+const CpuFeatures &cpu_features();
+
+// Kernel choices (or fixed at compile time, see below), set from cpu_features() during static
+// initialization. Code that runs earlier sees false and takes the portable path, which is always valid:
+// both slider table layouts are compile-time data.
+extern bool use_hw_popcnt;
+extern bool use_pext_sliders;
+extern bool use_avx2_fills;
+
+// One-line description of the selected kernels, e.g. "popcnt=hw ctz=bsf sliders=pext fills=avx2".
+std::string cpu_kernel_summary();
+
+// Population count. Builds with -mpopcnt (e.g. CHESS_ARCH=native) use the instruction directly;
+// generic x86-64 builds branch on a startup flag to POPCNT, falling back to the libgcc routine.
+inline int popcount(uint64_t b) {
+#if defined(__POPCNT__)
+  return static_cast<int>(_mm_popcnt_u64(b));
+#elif defined(__x86_64__) && defined(__GNUC__)
+  if (use_hw_popcnt) {
+    uint64_t r;
+    asm("popcntq %1, %0" : "=r"(r) : "rm"(b) : "cc");
+    return static_cast<int>(r);
+  }
+  return __builtin_popcountll(b);
+#else
+  return __builtin_popcountll(b);
+#endif
+}
+
+// Parallel bit extract: gathers the bits of src selected by mask into the low bits of the result.
+// Only called when use_pext_sliders is set, i.e. the host supports BMI2.
+inline uint64_t pext(uint64_t src, uint64_t mask) {
+#if defined(__BMI2__)
+  return _pext_u64(src, mask);
+#elif defined(__x86_64__) && defined(__GNUC__)
+  uint64_t r;
+  asm("pextq %2, %1, %0" : "=r"(r) : "r"(src), "rm"(mask));
+  return r;
+#else
+  uint64_t r = 0;
+  for (uint64_t bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+    if (src & mask & -mask) r |= bit;
+  }
+  return r;
+#endif
+}
+
+} // namespace chess
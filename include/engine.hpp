@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_map>
 #include <cstdint>
+#include <array>
 #include <atomic>
 #include "position.hpp"
 #include "movegen.hpp"
@@ -44,7 +45,23 @@ public:
     }
     
 protected:
+    // Occurrences of key in the game history plus the search path up to and including ply.
+    int repetition_count(uint64_t key, int ply) const {
+        auto it = position_history_.find(key);
+        int count = (it != position_history_.end()) ? it->second : 0;
+        for (int i = 0; i <= ply; ++i) {
+            if (path_keys_[i] == key) ++count;
+        }
+        return count;
+    }
+
+    // Deepest search path path_keys_ can hold; get_best_move clamps the requested depth below it.
+    static constexpr int MAX_PLY = 128;
+
     std::unordered_map<uint64_t, int> position_history_;
+    // Zobrist keys along the current search path (index = ply, root = 0).
+    // Replaces copying the history map at every node.
+    std::array<uint64_t, MAX_PLY + 1> path_keys_{};
     const std::atomic<bool>* stop_flag_ = nullptr;
 };
 
@@ -88,7 +88,6 @@ private:
     MoveGenerator movegen_;
     PlayerType players_[2];
     std::optional<int> selected_square_;
-    AttackTablesInitializer attack_tables_init_;
     GameStatus status_;
     std::vector<Move> legal_moves_;
     std::optional<int> last_move_from_;
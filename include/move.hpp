@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+
+namespace chess {
+
+// Move flags (upper 4 bits of a Move), set by MoveGenerator.
+// Promotions set PROMOTION and keep the promoted piece (promo - 1) in the low two bits.
+enum MoveFlag : int {
+  QUIET = 0,
+  DOUBLE_PUSH = 1,
+  KING_CASTLE = 2,
+  QUEEN_CASTLE = 3,
+  CAPTURE = 4,
+  EP_CAPTURE = 5,
+  PROMOTION = 8,
+  PROMO_CAPTURE = 12
+};
+
+// Packed 16-bit move: bits 0-5 from square, bits 6-11 to square, bits 12-15 flags.
+class Move {
+public:
+  constexpr Move() : data_(0) {}
+  // from 0..63, to 0..63, promo: 0 = no promotion, 1 = N, 2 = B, 3 = R, 4 = Q.
+  // Moves built this way (UCI input, GUI clicks) carry no capture/castle/en-passant flags.
+  constexpr Move(int f, int t, int p = 0) : data_(pack(f, t, p > 0 ? PROMOTION | (p - 1) : QUIET)) {}
+
+  // Build a move with explicit flags (used by MoveGenerator).
+  static constexpr Move make(int from, int to, int flags) {
+    Move m;
+    m.data_ = pack(from, to, flags);
+    return m;
+  }
+
+  constexpr int from() const { return data_ & 0x3F; }
+  constexpr int to() const { return (data_ >> 6) & 0x3F; }
+  constexpr int flags() const { return data_ >> 12; }
+  constexpr int promo() const { return is_promotion() ? (flags() & 3) + 1 : 0; }
+  constexpr uint16_t raw() const { return data_; }
+
+  constexpr bool is_capture() const { return flags() & CAPTURE; }
+  constexpr bool is_promotion() const { return flags() & PROMOTION; }
+  constexpr bool is_en_passant() const { return flags() == EP_CAPTURE; }
+  constexpr bool is_double_push() const { return flags() == DOUBLE_PUSH; }
+  constexpr bool is_castle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+
+  // Identity is (from, to, promo): a move parsed from UCI equals its generated, flagged twin.
+  constexpr bool operator==(const Move &other) const {
+    return (data_ & 0x0FFF) == (other.data_ & 0x0FFF) && promo() == other.promo();
+  }
+  constexpr bool operator!=(const Move &other) const { return !(*this == other); }
+
+private:
+  static constexpr uint16_t pack(int from, int to, int flags) {
+    return static_cast<uint16_t>(from | (to << 6) | (flags << 12));
+  }
+
+  uint16_t data_;
+};
+
+static_assert(sizeof(Move) == 2, "Move must stay packed into 16 bits");
+
+} // namespace chess
@@ -23,8 +23,8 @@ inline std::string square_to_notation(int sq) {
 }
 
 inline std::string format_move_for_log(const Move& move) {
-    std::string out = square_to_notation(move.from) + " -> " + square_to_notation(move.to);
-    char promo = promotion_piece_char(move.promo);
+    std::string out = square_to_notation(move.from()) + " -> " + square_to_notation(move.to());
+    char promo = promotion_piece_char(move.promo());
     if (promo != '\0') {
         out += " ";
         out += promo;
@@ -1,46 +1,151 @@
 #pragma once
 #include "position.hpp"
-
-#include <vector>
+#include "move.hpp"
 
 namespace chess {
 
-struct Move {
-  int from;     // 0..63
-  int to;       // 0..63
-  int promo;    // 0 = no promotion, 1 = N, 2 = B, 3 = R, 4 = Q
+// Fixed-capacity, stack-allocated move list with a score slot per move for ordering.
+// 256 is above the largest known number of legal moves in a chess position (218).
+class MoveList {
+public:
+  static constexpr int CAPACITY = 256;
+
+  void push_back(Move m) { moves_[size_++] = m; }
+  void clear() { size_ = 0; }
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
 
-  Move() : from(-1), to(-1), promo(0) {}
-  Move(int f, int t, int p = 0) : from(f), to(t), promo(p) {}
+  Move &operator[](int i) { return moves_[i]; }
+  const Move &operator[](int i) const { return moves_[i]; }
+  int &score(int i) { return scores_[i]; }
+  int score(int i) const { return scores_[i]; }
 
-  bool operator==(const Move &other) const {
-    return from == other.from && to == other.to && promo == other.promo;
+  Move *begin() { return moves_; }
+  Move *end() { return moves_ + size_; }
+  const Move *begin() const { return moves_; }
+  const Move *end() const { return moves_ + size_; }
+
+  // Stable sort by descending score (insertion sort: lists are short and mostly ordered).
+  void sort_by_score() {
+    for (int i = 1; i < size_; ++i) {
+      Move m = moves_[i];
+      int sc = scores_[i];
+      int j = i - 1;
+      while (j >= 0 && scores_[j] < sc) {
+        moves_[j + 1] = moves_[j];
+        scores_[j + 1] = scores_[j];
+        --j;
+      }
+      moves_[j + 1] = m;
+      scores_[j + 1] = sc;
+    }
   }
+
+private:
+  Move moves_[CAPACITY];
+  int scores_[CAPACITY];
+  int size_ = 0;
+};
+
+// Pieces in blocker_occ that are the only piece between sq and a slider of color `by`.
+// With our king and their sliders these are our pinned pieces; with their king and our sliders,
+// our discovered-check candidates.
+U64 slider_blockers(const Position &pos, int sq, Color by, U64 blocker_occ);
+
+// Per-node check information for the side to move, computed once and shared by every move tested:
+// the squares from which each piece type would attack the enemy king, and our pieces whose move off
+// the line to that king uncovers a check from one of our sliders.
+struct CheckInfo {
+  CheckInfo() = default;
+  explicit CheckInfo(const Position &pos);
+
+  int king_sq = 0;          // enemy king square
+  U64 check_squares[6] = {}; // indexed by PieceType; empty for the king
+  U64 discovered = 0;
+};
+
+// True if playing m (a legal move in pos) gives check, answered without making the move.
+bool gives_check(const Position &pos, const CheckInfo &ci, Move m);
+
+// What a generate<Type>() call produces. Every type except PSEUDO_LEGAL yields legal moves only.
+enum GenType : int {
+  CAPTURES,     // captures (including en passant) and all promotions
+  QUIETS,       // everything else: pushes, piece moves to empty squares, castling
+  QUIET_CHECKS, // quiet moves giving direct or discovered check (castling and promotions excluded)
+  EVASIONS,     // all legal moves, for a side in check
+  LEGAL,        // all legal moves
+  PSEUDO_LEGAL  // all pseudo-legal moves (may leave own king in check)
 };
 
 class MoveGenerator {
 public:
   explicit MoveGenerator(const Position &pos) : pos_(pos) {}
 
-  // Generate all pseudo-legal moves (excludes moves leaving own king in check).
-  std::vector<Move> generate_pseudo_legal();
+  // Generate moves of one type. The list overload appends, so stages can share a list.
+  // Moves come out in generation order; see order_moves() in search.hpp for capture-first ordering.
+  template <GenType Type> MoveList generate();
+  template <GenType Type> void generate(MoveList &moves);
+
+  // Generate all pseudo-legal moves (includes moves leaving own king in check).
+  MoveList generate_pseudo_legal() { return generate<PSEUDO_LEGAL>(); }
+
+  // Generate only legal moves. Checkers and pinned pieces are computed once up front: pinned pieces
+  // stay on the line through their king, and in check only evasions are produced (king moves, plus
+  // captures of / interpositions against a single checker).
+  MoveList generate_legal() { return generate<LEGAL>(); }
 
-  // Generate only capture moves (pseudo-legal).
-  // std::vector<Move> generate_captures();
+  // Generate only legal captures and promotions.
+  MoveList generate_captures() { return generate<CAPTURES>(); }
+
+  // True if m is a legal move here. Generates only the moves of the piece on m.from(),
+  // so it is cheap enough to validate a hash move before any stage is generated.
+  bool is_legal(Move m);
+
+  // True if the side to move has at least one legal move. Stops at the first piece type that has
+  // one, so mate and stalemate detection never pays for a full generation.
+  bool has_legal_move();
 
 private:
   const Position &pos_;
 
-  void add_pawn_moves(std::vector<Move> &moves);
-  void add_knight_moves(std::vector<Move> &moves);
-  void add_bishop_moves(std::vector<Move> &moves);
-  void add_rook_moves(std::vector<Move> &moves);
-  void add_queen_moves(std::vector<Move> &moves);
-  void add_king_moves(std::vector<Move> &moves);
-  void add_castling_moves(std::vector<Move> &moves);
+  // Legality state used by the piece generators. Pseudo-legal generation leaves these permissive.
+  bool legal_ = false;
+  int king_sq_ = 0;
+  U64 pinned_ = 0;           // our pieces pinned to our king
+  U64 target_mask_ = ~0ULL;  // squares a non-king move may land on (checker + blocking squares in check)
+  U64 from_mask_ = ~0ULL;    // squares whose pieces are expanded (narrowed by is_legal)
+
+  // Quiet-check state, filled only when generating QUIET_CHECKS
+  CheckInfo check_info_;
+
+  // Reset the legality state for Us: king square, pinned pieces and checkers (returned).
+  // False if legal generation was asked for and Us has no king.
+  template <Color Us> bool init_legality(bool legal, U64 &checkers);
+  template <Color Us> bool has_legal_move_for();
+
+  // Per-color generation: piece indices, push direction and back ranks are compile-time constants.
+  template <Color Us, GenType Type> void generate_for(MoveList &moves);
+  template <Color Us, GenType Type> void add_pawn_moves(MoveList &moves);
+  // Set-wise pawn generation for pawns sharing one target mask (allowed; push_allowed for quiet pushes)
+  template <Color Us, GenType Type> void add_pawn_set(MoveList &moves, U64 pawns, U64 allowed, U64 push_allowed);
+  // Serialize pawn targets: the pawn came from to - delta
+  void add_pawn_targets(MoveList &moves, U64 targets, int delta, int flags);
+  void add_pawn_promotions(MoveList &moves, U64 targets, int delta, int flags);
+  template <Color Us, GenType Type, PieceType Pt> void add_piece_moves(MoveList &moves, U64 targets);
+  template <Color Us, GenType Type> void add_king_moves(MoveList &moves, U64 targets);
+  template <Color Us> void add_castling_moves(MoveList &moves);
+
+  // Squares a non-king piece on `from` may move to: the check target mask, narrowed to the pin line
+  U64 legal_targets(int from) const;
+
+  // Squares a quiet move of a pt on `from` may go to and give check
+  U64 check_targets(PieceType pt, int from) const;
+
+  // Pieces of Us's opponent attacking sq, given occupancy occ
+  template <Color Us> U64 attackers_to(int sq, U64 occ) const;
 
-  // Sliding piece helpers
-  void add_sliding_moves(std::vector<Move> &moves, U64 pieces, const std::vector<std::pair<int, int>> &directions);
+  // Add a move from `from` to every square in targets (own pieces already removed)
+  void add_moves_from(MoveList &moves, int from, U64 targets);
 
   // Check if a move is a capture
   bool is_capture(int from, int to) const;
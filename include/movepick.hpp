@@ -0,0 +1,45 @@
+#pragma once
+#include "position.hpp"
+#include "movegen.hpp"
+
+namespace chess {
+
+// Lazy move picker for search. Hands out legal moves one at a time in stage order:
+// hash move, good captures (MVV-LVA order, SEE >= 0), quiets, then losing captures and underpromotions.
+// Each stage is generated only when the previous one runs dry, so a cutoff on the hash move or an early
+// capture skips the rest of generation. In check, all evasions are generated in a single stage instead.
+//
+// The position may be changed between calls (do_move/undo_move) as long as it is restored before the
+// next call to next_move().
+class MovePicker {
+public:
+  explicit MovePicker(const Position &pos, Move hash_move = Move());
+
+  // Next move, or Move() once every stage is exhausted.
+  Move next_move();
+
+private:
+  enum Stage {
+    HASH_MOVE,
+    CAPTURES_INIT, GOOD_CAPTURES,
+    QUIETS_INIT, QUIET_MOVES,
+    BAD_CAPTURES,
+    EVASIONS_INIT, EVASION_MOVES,
+    DONE
+  };
+
+  // Captures that don't lose material once the exchange on the target square plays out (SEE >= 0),
+  // and quiet promotions to a queen. Everything else, including every underpromotion, is tried after
+  // the quiets.
+  bool is_good_capture(Move m) const;
+
+  const Position &pos_;
+  MoveGenerator gen_;
+  Move hash_move_;
+  Stage stage_;
+  MoveList moves_;
+  MoveList bad_captures_;
+  int cur_ = 0;
+};
+
+} // namespace chess
@@ -0,0 +1,73 @@
+#pragma once
+#include "search.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chess {
+
+// Transposition table for bulk perft: (position, depth) -> node count. Fixed size, always-replace,
+// and lock-free: an entry is two independent 64-bit words, the packed count/depth and that value
+// XORed with the key, so an entry torn by a concurrent writer fails the key check and reads as a
+// miss. One table can be shared by every perft thread.
+class PerftTable {
+public:
+  explicit PerftTable(std::size_t mb);
+
+  bool probe(U64 key, int depth, uint64_t &nodes) const;
+  void store(U64 key, int depth, uint64_t nodes);
+  void clear();
+  std::size_t size() const { return mask_ + 1; } // entries
+
+private:
+  struct Entry {
+    std::atomic<U64> check{0}; // key ^ data
+    std::atomic<U64> data{0};  // nodes << 8 | depth
+  };
+  std::unique_ptr<Entry[]> entries_;
+  std::size_t mask_ = 0;
+};
+
+// Key of pos for the perft table: Position::key() plus the en passant file when a capture there is
+// possible, since that changes the moves below.
+U64 perft_key(const Position &pos);
+
+// Bulk perft node count through table: subtrees of depth >= 2 already counted are looked up
+uint64_t perft_hashed(Position &pos, int depth, PerftTable &table);
+
+// Parallel perft. The root moves (and, while there are few of them, the level below) become tasks
+// on per-thread deques. Workers pop their own newest task and steal the oldest task of another
+// worker when they run dry. A worker also splits a deep subtree into its children whenever another
+// worker is idle. Each worker searches on its own Position copy, so the results equal the serial
+// perft(pos, depth, mode) field for field.
+
+// One root move and the perft of the subtree below it
+struct PerftDivide {
+  Move move;
+  PerftStats stats;
+};
+
+// perft(pos, depth, mode) on `threads` worker threads (1 runs the same tasks on one worker).
+// With a table, bulk node counts go through perft_hashed, all workers sharing the table; full
+// statistics are never cached, so the table is ignored in PERFT_FULL mode.
+PerftStats perft_parallel(const Position &pos, int depth, int threads, PerftMode mode = PERFT_FULL,
+                          PerftTable *table = nullptr);
+
+// Per-root-move breakdown, in generation order; stats are those of the subtree below each move
+// (depth - 1 plies), so their sum equals perft_parallel for depth >= 2.
+std::vector<PerftDivide> perft_divide(const Position &pos, int depth, int threads, PerftMode mode = PERFT_FULL,
+                                      PerftTable *table = nullptr);
+
+// One line of a perft EPD suite: "<fen> ;D1 20 ;D2 400 ;D3 8902"
+struct PerftEpd {
+  std::string fen;
+  std::vector<std::pair<int, uint64_t>> expected; // (depth, nodes) in the order listed
+};
+
+// Parses one EPD line into out. Returns false for blank lines, '#' comments and lines without a FEN.
+bool parse_perft_epd(const std::string &line, PerftEpd &out);
+
+} // namespace chess
@@ -3,6 +3,7 @@
 #include <string>
 #include <array>
 #include <optional>
+#include "move.hpp"
 
 namespace chess {
 
@@ -22,6 +23,18 @@ enum class PlayerType { HUMAN, AI };
 
 inline Color piece_color(Piece p) { return p < 6 ? WHITE : BLACK; }
 inline PieceType piece_type(Piece p) { return PieceType(p % 6); }
+constexpr Piece make_piece(Color c, PieceType pt) { return Piece(c * 6 + pt); }
+constexpr Color operator~(Color c) { return Color(c ^ 1); }
+
+// State that do_move cannot recompute on undo. The caller owns it, typically as a local in the
+// recursion frame that makes the move, and hands the same object to the matching undo_move.
+struct StateInfo {
+  U64 key;
+  int halfmove;
+  int8_t captured; // piece captured by the move, or NO_PIECE
+  int8_t castling;
+  int8_t ep_square;
+};
 
 // Represents a chess position, including piece placement, side to move, castling rights, en passant square, and move counters.
 class Position {
@@ -42,9 +55,19 @@ public:
   int en_passant_square() const { return ep_square_; } // -1 if none
   int castling_rights() const { return castling_; }    // bitmask: WK=1,WQ=2,BK=4,BQ=8
   int halfmove_clock() const { return halfmove_; }    // halfmove clock for 50-move rule
+  U64 key() const { return key_; }                     // Zobrist key, maintained incrementally
 
   // query piece on square (0..63). Returns NO_PIECE if empty.
-  int piece_on_square(int sq) const;
+  int piece_on_square(int sq) const {
+    if (static_cast<unsigned>(sq) > 63) return NO_PIECE;
+    return board_[sq];
+  }
+
+  // Pieces of both colors attacking sq, looked up outward from sq with the attack tables.
+  // Pass a modified occupancy to ask "what attacks sq if this piece were gone" (x-rays, king walks).
+  U64 attackers_to(int sq, U64 occ) const;
+  U64 attackers_to(int sq) const { return attackers_to(sq, occupied()); }
+  bool is_square_attacked(int sq, Color by) const { return attackers_to(sq) & occupancy(by); }
 
   static int square_index(char file, char rank); // file 'a'..'h', rank '1'..'8'
 
@@ -55,6 +78,7 @@ public:
     int captured_piece;
     int old_castling, old_ep_sq, old_halfmove;
     bool was_ep_capture; // true if this was an en passant capture
+    U64 old_key;
   };
 
   // Apply a move (from, to, promo). Assumes the move is legal (from a legal-move list).
@@ -64,19 +88,39 @@ public:
   // Undo a previously applied move.
   void undo_move(const UnmoveInfo &info);
 
-  // Friend for castling legality check
-  friend bool is_castling_legal(const Position &pos, int from, int to);
+  // Fast-path make/unmake for search and perft. Trusts its input: the move must come from
+  // MoveGenerator (its flags classify the move) and be pseudo-legal in this position.
+  // Irreversible state goes into st rather than into Position, so copies stay small; undo_move takes
+  // the same st back and must be called in LIFO order.
+  void do_move(Move m, StateInfo &st);
+  void undo_move(Move m, const StateInfo &st);
 
 private:
+  // do_move/undo_move bodies per moving color, so pawn indices and side flips are compile-time constants.
+  template <Color Us> void do_move_for(Move m, StateInfo &st);
+  template <Color Us> void undo_move_for(Move m, const StateInfo &st);
+
+  // Keep bitboards_ and board_ in sync when adding, removing or moving a piece.
+  void put_piece(int piece, int sq);
+  void remove_piece(int sq);
+  void move_piece(int from, int to);
+  void set_castling(int rights);
+
+  // Debug check: the incremental key must match a full recompute.
+  void verify_key() const;
+
   // The underscore suffix marks private members and avoids ambiguity with method names.
   // bitboards_[12] holds bitboards for each piece type (WP, WN, ..., BK).
   // Each bitboard has a 1 in the position of squares occupied by that piece type.
   std::array<U64, 12> bitboards_{};
+  // board_[64] is a mailbox mirror of bitboards_: the piece on each square, or NO_PIECE.
+  std::array<int8_t, 64> board_{};
   Color side_ = WHITE; // side to move
   int ep_square_ = -1; // en passant target square (0..63), or -1 if none
   int castling_ = 0; // castling rights bitmask: WK=1, WQ=2, BK=4, BQ=8
   int halfmove_ = 0; // halfmove clock for 50-move rule
   int fullmove_ = 1; // fullmove number, starting at 1 and incremented after Black's move
+  U64 key_ = 0; // Zobrist key of the current position (see zobrist.hpp)
 };
 
 } // namespace chess
@@ -0,0 +1,58 @@
+#pragma once
+#include "position.hpp"
+#include "movegen.hpp"
+#include "attack_info.hpp"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace chess {
+
+// Many independent positions stored structure-of-arrays (one array per piece bitboard), for offline
+// jobs that need the moves of millions of positions. The legal-move work runs in SIMD lanes across
+// positions: four positions per AVX2 step, two per SSE2 step.
+//
+// Every position is stored from the side to move's point of view: a position with black to move is
+// mirrored top to bottom, so all lanes generate white moves. Generated moves are mirrored back.
+class PositionBatch {
+public:
+  void clear();
+  void reserve(std::size_t n);
+  void add(const Position &pos);
+  std::size_t size() const { return size_; }
+
+  // counts[i] = number of legal moves in position i. Legal moves are counted set-wise (one
+  // Kogge-Stone fill per slider direction) without being generated; a position without a king of the
+  // side to move counts 0, as in MoveGenerator.
+  void count_legal_moves(std::vector<int> &counts, FillKernel kernel = default_fill_kernel()) const;
+
+  // moves[i] = the legal moves of position i, the same set MoveGenerator::generate_legal() produces.
+  // Check and pin masks come from the SIMD pass; the moves are then serialized one position at a time.
+  void generate_legal(std::vector<MoveList> &moves, FillKernel kernel = default_fill_kernel()) const;
+
+  // Positions per SIMD step; the arrays are padded with empty boards to a multiple of this.
+  static constexpr std::size_t LANES = 4;
+
+private:
+  // Per-position legality masks produced by the SIMD pass (side to move's point of view)
+  struct Context {
+    U64 targets;   // squares a non-king move may land on: not ours, and blocking or capturing a single check
+    U64 pinned;    // our pieces pinned to our king
+    U64 danger;    // squares the opponent attacks, seen through our king
+    U64 checkers;  // opponent pieces giving check
+  };
+
+  // SIMD pass over all positions: fills counts and/or ctx (either may be null)
+  void analyze(int *counts, Context *ctx, FillKernel kernel) const;
+  // En passant captures of position i, checked one by one; appended to moves if not null
+  int en_passant_moves(std::size_t i, MoveList *moves) const;
+
+  // pieces_[pt][i]: our pieces of type pt in position i; pieces_[6 + pt][i]: the opponent's
+  std::array<std::vector<U64>, 12> pieces_;
+  std::vector<U64> castling_;        // king destinations we hold castling rights for (g1, c1)
+  std::vector<int8_t> ep_square_;    // -1 if none
+  std::vector<uint8_t> mirrored_;    // 1 if black is to move (board mirrored)
+  std::size_t size_ = 0;
+};
+
+} // namespace chess
@@ -27,8 +27,11 @@ private:
     // Negamax with alpha-beta pruning
     // Returns the best score from the current player's perspective
     // Always maximizes; perspective is handled by negating recursive calls
-    int alphabeta(Position& position, int depth, int alpha, int beta,
-                  std::unordered_map<uint64_t, int> position_history);
+    int alphabeta(Position& position, int depth, int alpha, int beta, int ply);
+
+    // evaluate() with the legal-move status already known to the caller, so terminal
+    // detection does not generate moves again
+    int evaluate_node(Position& position, bool has_legal_moves);
 
     bool use_time_limit_ = false;
     std::chrono::steady_clock::time_point deadline_{};
@@ -46,23 +46,72 @@ struct PerftStats {
   }
 };
 
-// Perft driver: counts nodes, captures, and other stats to a given depth.
-// Depth 0 returns 1 node (the current position).
+// PerftStats fields besides nodes, for choosing what perft<Stats> computes
+enum PerftField : unsigned {
+  PERFT_CAPTURES = 1,
+  PERFT_EN_PASSANTS = 2,
+  PERFT_CASTLES = 4,
+  PERFT_PROMOTIONS = 8,
+  PERFT_CHECKS = 16,
+  PERFT_CHECKMATES = 32,
+  PERFT_ALL_FIELDS = 63
+};
+
+// Perft statistics policy: which PerftStats fields perft<Stats> fills. Every test on a field is a
+// compile-time constant, so a field not asked for costs nothing and stays 0. Checks cost a
+// gives_check per leaf move; checkmates also make each checking leaf move and search it for a reply.
+template <unsigned Fields>
+struct PerftCounters {
+  static constexpr bool captures = Fields & PERFT_CAPTURES;
+  static constexpr bool en_passants = Fields & PERFT_EN_PASSANTS;
+  static constexpr bool castles = Fields & PERFT_CASTLES;
+  static constexpr bool promotions = Fields & PERFT_PROMOTIONS;
+  static constexpr bool checks = Fields & PERFT_CHECKS;
+  static constexpr bool checkmates = Fields & PERFT_CHECKMATES;
+};
+
+using PerftNodes = PerftCounters<0>;               // node count only
+using PerftFull = PerftCounters<PERFT_ALL_FIELDS>; // every field
+
+// What a perft run computes, for callers choosing at runtime. PERFT_FULL fills every PerftStats
+// field (perft<PerftFull>), PERFT_BULK fills nodes only (perft<PerftNodes>).
+enum PerftMode { PERFT_FULL, PERFT_BULK };
+
+// Perft driver: counts nodes and the fields Stats asks for to a given depth.
+// Depth 0 returns 1 node (the current position). The moves at depth 1 are counted from the legal
+// move list without being made, except checking moves when checkmates are counted.
+template <typename Stats>
 PerftStats perft(Position &pos, int depth);
 
+// perft<PerftFull> or perft<PerftNodes>, picked once at the root
+PerftStats perft(Position &pos, int depth, PerftMode mode = PERFT_FULL);
+
+// Node count only (perft<PerftNodes>(pos, depth).nodes)
+uint64_t perft_bulk(Position &pos, int depth);
+
 // Perft breakdown by first move (Stockfish-style).
 // Prints nodes explored for each legal first move at the given depth.
-void perft_by_move(Position &pos, int depth);
+void perft_by_move(Position &pos, int depth, PerftMode mode = PERFT_FULL);
 
 // Helper: check if a side's king is in check
 bool is_in_check(const Position &pos, Color side);
 
+// Same, with the side fixed at compile time for callers that already know it
+template <Color Side>
+bool is_in_check(const Position &pos) {
+  U64 king = pos.bitboard(make_piece(Side, KING));
+  return king && (pos.attackers_to(__builtin_ctzll(king)) & pos.occupancy(~Side));
+}
+
 // Helper: check if a side is in checkmate
 bool is_checkmate(Position &pos, Color side);
 
 // Helper: check if a side is in stalemate (not in check, but no legal moves)
 bool is_stalemate(Position &pos, Color side);
 
+// Helper: check if the side to move has any legal move (stops at the first one found)
+bool has_legal_move(const Position &pos);
+
 // Helper: check if the position is a draw by 50-move rule
 bool is_draw_by_50_move_rule(const Position &pos);
 
@@ -73,7 +122,59 @@ bool is_threefold_repetition(const std::unordered_map<uint64_t, int>& position_h
 // Helper: check if a castling move is legal (king doesn't move through check)
 bool is_castling_legal(const Position &pos, int from, int to);
 
-// Generate all legal moves (pseudo-legal moves that don't leave king in check)
-std::vector<Move> get_legal_moves(Position &pos);
+// Generate all legal moves (see MoveGenerator::generate_legal)
+MoveList get_legal_moves(Position &pos);
+
+// Move ordering: score captures (MVV-LVA) and promotions above quiet moves, then sort the list.
+// Call before iterating moves in alpha-beta so likely cutoffs are searched first.
+void order_moves(const Position &pos, MoveList &moves);
+
+// Adds the perft of pos (depth >= 1) to stats; the recursion behind perft<Stats>
+template <typename Stats>
+void perft_count(Position &pos, int depth, PerftStats &stats) {
+  MoveList moves = MoveGenerator(pos).generate_legal();
+  if (depth > 1) {
+    for (const auto &m : moves) {
+      StateInfo st;
+      pos.do_move(m, st);
+      perft_count<Stats>(pos, depth - 1, stats);
+      pos.undo_move(m, st);
+    }
+    return;
+  }
+
+  // Leaf moves: the node count is the list size, the move types come straight from the flags
+  stats.nodes += moves.size();
+  if constexpr (Stats::captures || Stats::en_passants || Stats::castles || Stats::promotions ||
+                Stats::checks || Stats::checkmates) {
+    // Check info is only needed for the check stats
+    CheckInfo ci;
+    if constexpr (Stats::checks || Stats::checkmates) ci = CheckInfo(pos);
+    for (const auto &m : moves) {
+      if constexpr (Stats::captures) stats.captures += m.is_capture();
+      if constexpr (Stats::en_passants) stats.en_passants += m.is_en_passant();
+      if constexpr (Stats::castles) stats.castles += m.is_castle();
+      if constexpr (Stats::promotions) stats.promotions += m.is_promotion();
+      if constexpr (Stats::checks || Stats::checkmates) {
+        if (!gives_check(pos, ci, m)) continue;
+        if constexpr (Stats::checks) stats.checks++;
+        if constexpr (Stats::checkmates) {
+          StateInfo st;
+          pos.do_move(m, st);
+          stats.checkmates += !has_legal_move(pos);
+          pos.undo_move(m, st);
+        }
+      }
+    }
+  }
+}
+
+template <typename Stats>
+PerftStats perft(Position &pos, int depth) {
+  PerftStats stats;
+  if (depth == 0) stats.nodes = 1; // base case: leaf node
+  else perft_count<Stats>(pos, depth, stats);
+  return stats;
+}
 
 } // namespace chess
@@ -0,0 +1,19 @@
+#pragma once
+#include "position.hpp"
+
+namespace chess {
+
+// Static Exchange Evaluation: the material balance (centipawns, from the mover's point of view) of
+// the capture sequence on m.to() when both sides always recapture with their least valuable piece and
+// may stop whenever continuing would lose material. Sliders hidden behind a capturing piece (x-rays)
+// join the exchange as the pieces in front of them leave.
+
+// Piece values used by SEE, indexed by PieceType. The king outweighs any exchange.
+inline constexpr int see_value[6] = {100, 320, 330, 500, 900, 20000};
+
+int see(const Position &pos, Move m);
+
+// see(pos, m) >= threshold, with early exits for the common clear-cut cases.
+bool see_ge(const Position &pos, Move m, int threshold = 0);
+
+} // namespace chess
@@ -8,8 +8,55 @@ namespace chess {
 // Zobrist hashing for position fingerprinting
 // Used for threefold repetition detection
 
-// Generate a 64-bit hash for a position (excludes en passant square per FIDE rules)
+namespace zobrist {
+
+// Zobrist key tables: 12 pieces * 64 squares, side to move, 16 castling-rights combinations.
+// en_passant (by file) is not part of Position::key(); tables that must tell such positions apart
+// (the perft hash table) XOR it in themselves.
+struct Keys {
+    uint64_t piece[12][64];
+    uint64_t side;
+    uint64_t castling[16];
+    uint64_t en_passant[8];
+};
+
+// splitmix64 step: small, fast and good enough to fill the tables at compile time
+constexpr uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr Keys make_keys() {
+    // Use a fixed seed for reproducibility
+    uint64_t state = 0xDEADBEEFCAFEBABEULL;
+    Keys k{};
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            k.piece[piece][square] = splitmix64(state);
+        }
+    }
+    k.side = splitmix64(state);
+    for (int i = 0; i < 16; i++) {
+        k.castling[i] = splitmix64(state);
+    }
+    for (int file = 0; file < 8; file++) {
+        k.en_passant[file] = splitmix64(state);
+    }
+    return k;
+}
+
+// Built at compile time: no lazy initialization and no init race between threads.
+inline constexpr Keys keys = make_keys();
+
+} // namespace zobrist
+
+// Recompute a position's hash from scratch (excludes en passant square per FIDE rules)
 // Includes: piece placement, side to move, castling rights
-uint64_t get_position_hash(const Position& pos);
+uint64_t compute_position_hash(const Position& pos);
+
+// Get the 64-bit hash for a position. O(1): Position maintains the key incrementally.
+inline uint64_t get_position_hash(const Position& pos) { return pos.key(); }
 
 } // namespace chess
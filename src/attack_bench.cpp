@@ -0,0 +1,95 @@
+// Times building both colors' attack maps, by piece type: the set-wise Kogge-Stone kernels against
+// one magic (or pext) lookup per piece.
+// Usage: chess_attack_bench [iterations]
+// Positions are collected from a short walk of the move tree from a few test positions.
+#include "attack_info.hpp"
+#include "attacks.hpp"
+#include "search.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+void collect(Position &pos, int depth, std::vector<Position> &out) {
+  out.push_back(pos);
+  if (depth == 0) return;
+  for (const auto &m : get_legal_moves(pos)) {
+    StateInfo st;
+    pos.do_move(m, st);
+    collect(pos, depth - 1, out);
+    pos.undo_move(m, st);
+  }
+}
+
+// The same maps as compute_attack_info, one table lookup per piece
+void per_square_attacks(const Position &pos, AttackInfo &info) {
+  for (int c = 0; c < 2; ++c) {
+    Color color = static_cast<Color>(c);
+    U64 occ = pos.occupied() ^ pos.bitboard(make_piece(~color, KING));
+    U64 *at = info.by_type[c];
+    U64 b;
+    at[PAWN] = at[KNIGHT] = at[BISHOP] = at[ROOK] = at[QUEEN] = 0;
+    for (b = pos.bitboard(make_piece(color, PAWN)); b; b &= b - 1) at[PAWN] |= pawn_attacks[c][__builtin_ctzll(b)];
+    for (b = pos.bitboard(make_piece(color, KNIGHT)); b; b &= b - 1) at[KNIGHT] |= knight_attacks[__builtin_ctzll(b)];
+    for (b = pos.bitboard(make_piece(color, BISHOP)); b; b &= b - 1) at[BISHOP] |= bishop_attacks(__builtin_ctzll(b), occ);
+    for (b = pos.bitboard(make_piece(color, ROOK)); b; b &= b - 1) at[ROOK] |= rook_attacks(__builtin_ctzll(b), occ);
+    for (b = pos.bitboard(make_piece(color, QUEEN)); b; b &= b - 1) at[QUEEN] |= queen_attacks(__builtin_ctzll(b), occ);
+    b = pos.bitboard(make_piece(color, KING));
+    at[KING] = b ? king_attacks[__builtin_ctzll(b)] : 0;
+    info.all[c] = at[PAWN] | at[KNIGHT] | at[BISHOP] | at[ROOK] | at[QUEEN] | at[KING];
+  }
+}
+
+// Best-of-5 nanoseconds per position; the checksum keeps the work from being optimized away
+template <class Fn>
+void run(const char *name, const std::vector<Position> &positions, int iterations, Fn fn) {
+  double best = 1e30;
+  U64 checksum = 0;
+  for (int round = 0; round < 5; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      for (const auto &pos : positions) {
+        AttackInfo info;
+        fn(pos, info);
+        checksum += info.all[WHITE] ^ info.all[BLACK];
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+  }
+  std::cout << name << ": " << best / (double(iterations) * positions.size()) << " ns/position"
+            << " (checksum " << (checksum & 0xffff) << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+  const char *fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+  };
+  std::vector<Position> positions;
+  for (const char *fen : fens) {
+    Position pos;
+    pos.set_from_fen(fen);
+    collect(pos, 2, positions);
+  }
+
+  std::cout << "kernels " << cpu_kernel_summary() << ", " << positions.size() << " positions" << std::endl;
+  run("per-square lookups", positions, iterations, per_square_attacks);
+  run("kogge-stone scalar", positions, iterations,
+      [](const Position &pos, AttackInfo &info) { compute_attack_info(pos, info, FILL_SCALAR); });
+  run("kogge-stone sse2  ", positions, iterations,
+      [](const Position &pos, AttackInfo &info) { compute_attack_info(pos, info, FILL_SSE2); });
+  run("kogge-stone avx2  ", positions, iterations,
+      [](const Position &pos, AttackInfo &info) { compute_attack_info(pos, info, FILL_AVX2); });
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "attack_info.hpp"
+#include "bitboard_fill.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CHESS_X86_FILLS 1
+#endif
+
+namespace chess {
+
+namespace {
+
+using namespace fill;
+
+// Four slider sets per call: lanes {bishops or rooks, white and black; queens, white and black}.
+// diag[] is expanded along the four diagonals, ortho[] along ranks and files.
+struct SliderLanes {
+  U64 diag[4];
+  U64 ortho[4];
+  U64 empty[4];     // per-lane occluders: empty squares, the enemy king counted as empty
+};
+
+// Fills lane_count<V> slider sets per step: one with V = U64, two per SSE2 register, four per AVX2 one
+template <class V>
+FILL_INLINE void slider_fills(const SliderLanes &in, U64 diag[4], U64 ortho[4]) {
+  for (int i = 0; i < 4; i += lane_count<V>) {
+    V d = load<V>(in.diag + i), o = load<V>(in.ortho + i), pro = load<V>(in.empty + i);
+    store(diag + i, occluded_fill<9>(d, pro) | occluded_fill<7>(d, pro) |
+                    occluded_fill<-7>(d, pro) | occluded_fill<-9>(d, pro));
+    store(ortho + i, occluded_fill<8>(o, pro) | occluded_fill<-8>(o, pro) |
+                     occluded_fill<1>(o, pro) | occluded_fill<-1>(o, pro));
+  }
+}
+
+#if defined(CHESS_X86_FILLS)
+// Compiled for AVX2 regardless of -march and only called after CPUID reported it
+__attribute__((target("avx2"))) void slider_fills_avx2(const SliderLanes &in, U64 diag[4], U64 ortho[4]) {
+  slider_fills<U64x4>(in, diag, ortho);
+}
+#endif
+
+struct CacheEntry {
+  U64 key = 0;
+  U64 occ = 0; // a real position is never empty, so a zeroed entry never matches
+  AttackInfo info;
+};
+
+// Direct-mapped by the low key bits: large enough to hold a search path's nodes and their siblings
+thread_local CacheEntry attack_cache[64];
+
+} // namespace
+
+AttackInfo::AttackInfo(const Position &pos) { compute_attack_info(pos, *this, default_fill_kernel()); }
+
+FillKernel default_fill_kernel() {
+#if defined(CHESS_X86_FILLS)
+  return use_avx2_fills ? FILL_AVX2 : FILL_SSE2;
+#else
+  return FILL_SCALAR;
+#endif
+}
+
+void compute_attack_info(const Position &pos, AttackInfo &info, FillKernel kernel) {
+  U64 occ = pos.occupied();
+  U64 kings[2] = {pos.bitboard(WK), pos.bitboard(BK)};
+
+  SliderLanes lanes;
+  for (int c = 0; c < 2; ++c) {
+    Color color = static_cast<Color>(c);
+    U64 queens = pos.bitboard(make_piece(color, QUEEN));
+    lanes.diag[c] = pos.bitboard(make_piece(color, BISHOP));
+    lanes.ortho[c] = pos.bitboard(make_piece(color, ROOK));
+    lanes.diag[2 + c] = queens;
+    lanes.ortho[2 + c] = queens;
+    lanes.empty[c] = lanes.empty[2 + c] = ~(occ ^ kings[c ^ 1]);
+  }
+
+  U64 diag[4], ortho[4];
+#if defined(CHESS_X86_FILLS)
+  if (kernel == FILL_AVX2 && cpu_features().avx2) {
+    slider_fills_avx2(lanes, diag, ortho);
+  } else if (kernel != FILL_SCALAR) {
+    slider_fills<U64x2>(lanes, diag, ortho);
+  } else {
+    slider_fills<U64>(lanes, diag, ortho);
+  }
+#else
+  (void)kernel;
+  slider_fills<U64>(lanes, diag, ortho);
+#endif
+
+  U64 white_pawns = pos.bitboard(WP);
+  U64 black_pawns = pos.bitboard(BP);
+  info.by_type[WHITE][PAWN] = (shift<7>(white_pawns) & ~FILE_H) | (shift<9>(white_pawns) & ~FILE_A);
+  info.by_type[BLACK][PAWN] = (shift<-9>(black_pawns) & ~FILE_H) | (shift<-7>(black_pawns) & ~FILE_A);
+
+  for (int c = 0; c < 2; ++c) {
+    Color color = static_cast<Color>(c);
+    U64 *at = info.by_type[c];
+    at[KNIGHT] = knight_fill(pos.bitboard(make_piece(color, KNIGHT)));
+    at[BISHOP] = diag[c];
+    at[ROOK] = ortho[c];
+    at[QUEEN] = diag[2 + c] | ortho[2 + c];
+    at[KING] = kings[c] ? king_attacks[__builtin_ctzll(kings[c])] : 0;
+    info.all[c] = at[PAWN] | at[KNIGHT] | at[BISHOP] | at[ROOK] | at[QUEEN] | at[KING];
+  }
+}
+
+const AttackInfo &attack_info(const Position &pos) {
+  CacheEntry &entry = attack_cache[pos.key() & 63];
+  U64 occ = pos.occupied();
+  if (entry.key != pos.key() || entry.occ != occ) {
+    compute_attack_info(pos, entry.info, default_fill_kernel());
+    entry.key = pos.key();
+    entry.occ = occ;
+  }
+  return entry.info;
+}
+
+} // namespace chess
@@ -1,52 +1,184 @@
 #include "attacks.hpp"
 
-#include <cstdlib>
+#include <utility>
 
 namespace chess {
 
-U64 knight_attacks[64];
-U64 king_attacks[64];
-
-std::once_flag AttackTablesInitializer::init_flag_;
-
-void init_attack_tables() {
-  // Initialize knight attacks
-  for (int sq = 0; sq < 64; ++sq) {
-    U64 atk = 0;
-    int f = sq % 8, r = sq / 8;
-
-    // All 8 knight deltas (2 squares in one direction, 1 in perpendicular)
-    static const int knight_deltas[] = {-17, -15, -10, -6, 6, 10, 15, 17};
-    for (int delta : knight_deltas) {
-      int to = sq + delta;
-      if (to >= 0 && to < 64) {
-        int tf = to % 8, tr = to / 8;
-        // Verify knight stays within 2 files of origin (prevents wrapping)
-        if (std::abs(f - tf) <= 2 && std::abs(r - tr) <= 2) {
-          atk |= (1ULL << to);
-        }
-      }
+// Every table in this file is evaluated by the compiler and emitted as read-only data:
+// there is no runtime initialization and nothing to guard with a once-flag.
+
+namespace {
+
+constexpr int file_of(int sq) { return sq % 8; }
+constexpr int rank_of(int sq) { return sq / 8; }
+
+constexpr int count_bits(U64 b) {
+  int n = 0;
+  for (; b; b &= b - 1) ++n;
+  return n;
+}
+
+// Portable pext for building the BMI2-indexed tables at compile time.
+constexpr U64 soft_pext(U64 src, U64 mask) {
+  U64 r = 0;
+  for (U64 bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+    if (src & mask & (0 - mask)) r |= bit;
+  }
+  return r;
+}
+
+// Squares reached by the given (file, rank) steps from sq, without wrapping around the board.
+template <std::size_t N>
+constexpr U64 step_attacks(int sq, const int (&deltas)[N][2]) {
+  U64 atk = 0;
+  for (const auto &d : deltas) {
+    int nf = file_of(sq) + d[0], nr = rank_of(sq) + d[1];
+    if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) atk |= (1ULL << (nr * 8 + nf));
+  }
+  return atk;
+}
+
+constexpr int knight_deltas[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+constexpr int king_deltas[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+constexpr int white_pawn_deltas[2][2] = {{-1, 1}, {1, 1}};
+constexpr int black_pawn_deltas[2][2] = {{-1, -1}, {1, -1}};
+
+template <std::size_t N>
+constexpr std::array<U64, 64> step_table(const int (&deltas)[N][2]) {
+  std::array<U64, 64> t{};
+  for (int sq = 0; sq < 64; ++sq) t[sq] = step_attacks(sq, deltas);
+  return t;
+}
+
+constexpr int bishop_dirs[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+constexpr int rook_dirs[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+// Walk the four rays from sq, stopping at (and including) the first occupied square.
+constexpr U64 ray_attacks(int sq, U64 occ, bool rook) {
+  const auto &dirs = rook ? rook_dirs : bishop_dirs;
+  U64 atk = 0;
+  for (const auto &d : dirs) {
+    for (int nf = file_of(sq) + d[0], nr = rank_of(sq) + d[1]; nf >= 0 && nf < 8 && nr >= 0 && nr < 8; nf += d[0], nr += d[1]) {
+      atk |= (1ULL << (nr * 8 + nf));
+      if (occ & (1ULL << (nr * 8 + nf))) break;
     }
-    knight_attacks[sq] = atk;
   }
+  return atk;
+}
 
-  // Initialize king attacks
-  for (int sq = 0; sq < 64; ++sq) {
-    U64 atk = 0;
-    int f = sq % 8, r = sq / 8;
-
-    for (int dr = -1; dr <= 1; ++dr) {
-      for (int df = -1; df <= 1; ++df) {
-        if (dr == 0 && df == 0) continue;
-        int nf = f + df, nr = r + dr;
-        if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) {
-          int to = nr * 8 + nf;
-          atk |= (1ULL << to);
-        }
+// Relevant occupancy: edge squares never block anything further along the ray, so drop them.
+constexpr U64 slider_mask(int sq, bool rook) {
+  U64 edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * rank_of(sq)))) | ((FILE_A | FILE_H) & ~(FILE_A << file_of(sq)));
+  return ray_attacks(sq, 0, rook) & ~edges;
+}
+
+// Magic multipliers, found offline by random search for shift = 64 - popcount(mask).
+constexpr U64 bishop_magic_numbers[64] = {
+  0x0c08081028882700ULL, 0x0208088820424040ULL, 0x2188480100202561ULL, 0x0004104610800140ULL,
+  0x9004504100002000ULL, 0x0a010108c0010041ULL, 0x3800491028200000ULL, 0x0000802101202002ULL,
+  0x81020410b0810100ULL, 0x0408082808404040ULL, 0x0106220084008008ULL, 0x0040182841001082ULL,
+  0x158404504000800eULL, 0x0888810108432808ULL, 0x0100020811180808ULL, 0x0801420a02410400ULL,
+  0x1320559102103101ULL, 0x0182002002240102ULL, 0xa910000200260020ULL, 0x0008010628210000ULL,
+  0x8002000402114461ULL, 0x0000204410080800ULL, 0x0400500205100900ULL, 0x2002014880840100ULL,
+  0x01e1100108102148ULL, 0x0410090044115400ULL, 0x4004084010104040ULL, 0x0202002008008220ULL,
+  0x0001001105004020ULL, 0x0001081022080400ULL, 0x2018842000820806ULL, 0x40008e0000210401ULL,
+  0x2314104102082200ULL, 0x0002100500101109ULL, 0x1224040201411200ULL, 0x0202004040040102ULL,
+  0x0040002022020080ULL, 0x2020004081210080ULL, 0x0442020404004401ULL, 0x0408c08a00090104ULL,
+  0x0898a21821004003ULL, 0xb004189210424820ULL, 0x8008131088031000ULL, 0x0009010148010500ULL,
+  0x2100084104000040ULL, 0x110102108200a100ULL, 0x0010120801144060ULL, 0x0002020a24200200ULL,
+  0x0020880808040000ULL, 0x0a8b041201040103ULL, 0x0140120205114002ULL, 0x6282000242021201ULL,
+  0x080080140d0c0122ULL, 0x0181102011810200ULL, 0x0804041032420400ULL, 0x0020842c00414142ULL,
+  0x06498028010c2082ULL, 0x0062202084042010ULL, 0x8100000211008800ULL, 0x6000000000840400ULL,
+  0x0018000008210100ULL, 0x00040011a0010100ULL, 0x0820090210020204ULL, 0x0402482804858200ULL
+};
+
+constexpr U64 rook_magic_numbers[64] = {
+  0x9880004000102080ULL, 0x9040001000200041ULL, 0x1100200010400900ULL, 0x2080080005801000ULL,
+  0x0200041020080200ULL, 0x0200041041084200ULL, 0x0400080081124410ULL, 0x2180042100004080ULL,
+  0x8000800099644000ULL, 0x0802003040820100ULL, 0x0105801001862000ULL, 0x0101002008100100ULL,
+  0x1000800400080080ULL, 0x0804800200040080ULL, 0x2001800200800900ULL, 0x00160004088204c1ULL,
+  0x228000c001402000ULL, 0x8510004000200050ULL, 0x3001848020029000ULL, 0x0280808010000801ULL,
+  0x0109010010040800ULL, 0x8000808004000200ULL, 0x8000040081021028ULL, 0x40040a0009004884ULL,
+  0x80c0004280008035ULL, 0x0010004040002000ULL, 0x1101200500410070ULL, 0x8410100080080080ULL,
+  0x000c080080800400ULL, 0x4012008080040002ULL, 0x4000040101000200ULL, 0x0061010200008044ULL,
+  0x0080804010800020ULL, 0x3000201008400040ULL, 0x4112008012002444ULL, 0x0848000880801000ULL,
+  0x00a8008008800400ULL, 0x200200280a00500cULL, 0x080a221024004801ULL, 0xc400008042000104ULL,
+  0x8000400080028022ULL, 0x0220008040018020ULL, 0x4000200011010040ULL, 0x10060040210a0010ULL,
+  0x40820020904a0004ULL, 0x0030040002008080ULL, 0x0200020801840010ULL, 0x0084c04100820004ULL,
+  0x4802010080c2a600ULL, 0x0000400080201880ULL, 0x2040801000200080ULL, 0x0180200842001200ULL,
+  0x0013510008000500ULL, 0x0182000c00808a80ULL, 0x1000524821302400ULL, 0x3800040108488200ULL,
+  0x104a004810210082ULL, 0x0004210010420082ULL, 0xc424110008200241ULL, 0x90101000a0088501ULL,
+  0x0182000420100802ULL, 0x4822001001080402ULL, 0x05d0080090012204ULL, 0x2008140089042846ULL
+};
+
+using SquareTable = std::array<std::array<U64, 64>, 64>;
+
+// between_bb[a][b]: squares strictly between a and b; line_bb[a][b]: the full line through both, including
+// a and b. Both are empty when a and b share no rank, file or diagonal (or a == b).
+constexpr SquareTable make_square_table(bool full_line) {
+  SquareTable t{};
+  for (int a = 0; a < 64; ++a) {
+    for (int b = 0; b < 64; ++b) {
+      U64 bb = 1ULL << b, ab = 1ULL << a;
+      for (bool rook : {false, true}) {
+        if (a == b || !(ray_attacks(a, 0, rook) & bb)) continue;
+        t[a][b] = full_line ? (ray_attacks(a, 0, rook) & ray_attacks(b, 0, rook)) | ab | bb
+                            : ray_attacks(a, bb, rook) & ray_attacks(b, ab, rook);
       }
     }
-    king_attacks[sq] = atk;
   }
+  return t;
+}
+
+// One square's slice of a slider table, indexed by magic multiply or by pext.
+// Each slice is its own constant evaluation, which keeps every evaluation well inside compiler limits.
+template <int Sq, bool Rook, bool Pext>
+constexpr auto build_slider_slice() {
+  constexpr U64 mask = slider_mask(Sq, Rook);
+  constexpr U64 magic = Rook ? rook_magic_numbers[Sq] : bishop_magic_numbers[Sq];
+  constexpr int bits = count_bits(mask);
+  std::array<U64, (1u << bits)> slice{};
+  // Enumerate every subset of the mask (carry-rippler) and store its attack set
+  U64 occ = 0;
+  do {
+    U64 index = Pext ? soft_pext(occ, mask) : ((occ * magic) >> (64 - bits));
+    slice[index] = ray_attacks(Sq, occ, Rook);
+    occ = (occ - mask) & mask;
+  } while (occ);
+  return slice;
+}
+
+template <int Sq, bool Rook, bool Pext>
+constexpr auto slider_slice = build_slider_slice<Sq, Rook, Pext>();
+
+template <int Sq, bool Rook>
+constexpr Magic make_magic() {
+  Magic m{};
+  m.mask = slider_mask(Sq, Rook);
+  m.magic = Rook ? rook_magic_numbers[Sq] : bishop_magic_numbers[Sq];
+  m.shift = 64 - count_bits(m.mask);
+  m.attacks = slider_slice<Sq, Rook, false>.data();
+#if defined(__x86_64__)
+  m.pext_attacks = slider_slice<Sq, Rook, true>.data();
+#endif
+  return m;
+}
+
+template <bool Rook, std::size_t... Sq>
+constexpr std::array<Magic, 64> make_magics(std::index_sequence<Sq...>) {
+  return {make_magic<static_cast<int>(Sq), Rook>()...};
 }
 
+} // namespace
+
+constexpr std::array<U64, 64> knight_attacks = step_table(knight_deltas);
+constexpr std::array<U64, 64> king_attacks = step_table(king_deltas);
+constexpr std::array<std::array<U64, 64>, 2> pawn_attacks = {step_table(white_pawn_deltas), step_table(black_pawn_deltas)};
+
+constexpr std::array<std::array<U64, 64>, 64> between_bb = make_square_table(false);
+constexpr std::array<std::array<U64, 64>, 64> line_bb = make_square_table(true);
+
+constexpr std::array<Magic, 64> bishop_magics = make_magics<false>(std::make_index_sequence<64>{});
+constexpr std::array<Magic, 64> rook_magics = make_magics<true>(std::make_index_sequence<64>{});
+
 } // namespace chess
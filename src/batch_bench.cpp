@@ -0,0 +1,96 @@
+// Positions per second for legal move counting and generation: one MoveGenerator per position
+// against PositionBatch's SIMD kernels.
+// Usage: chess_batch_bench [rounds]
+// Positions are collected from a walk of the move tree from a few test positions.
+#include "position_batch.hpp"
+#include "search.hpp"
+#include "cpu.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+void collect(Position &pos, int depth, std::vector<Position> &out) {
+  out.push_back(pos);
+  if (depth == 0) return;
+  for (const auto &m : get_legal_moves(pos)) {
+    StateInfo st;
+    pos.do_move(m, st);
+    collect(pos, depth - 1, out);
+    pos.undo_move(m, st);
+  }
+}
+
+// Best of `rounds` runs of fn over all positions, reported as positions/sec. The move total is printed
+// so every variant can be checked against the others.
+template <class Fn>
+void run(const char *name, std::size_t positions, int rounds, Fn fn) {
+  double best = 1e30;
+  long long total = 0;
+  for (int round = 0; round < rounds; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    total = fn();
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  std::cout << name << ": " << static_cast<long long>(positions / best) << " positions/s"
+            << " (" << total << " moves)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int rounds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+  const char *fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+  };
+  std::vector<Position> positions;
+  for (const char *fen : fens) {
+    Position pos;
+    pos.set_from_fen(fen);
+    collect(pos, 3, positions);
+  }
+  PositionBatch batch;
+  batch.reserve(positions.size());
+  for (const auto &pos : positions) batch.add(pos);
+
+  std::cout << "kernels " << cpu_kernel_summary() << ", " << positions.size() << " positions" << std::endl;
+  run("scalar generate_pseudo_legal  ", positions.size(), rounds, [&] {
+    long long n = 0;
+    for (const auto &pos : positions) n += MoveGenerator(pos).generate_pseudo_legal().size();
+    return n;
+  });
+  run("scalar generate_legal         ", positions.size(), rounds, [&] {
+    long long n = 0;
+    for (const auto &pos : positions) n += MoveGenerator(pos).generate_legal().size();
+    return n;
+  });
+
+  std::vector<int> counts;
+  std::vector<MoveList> moves;
+  const std::pair<const char *, FillKernel> kernels[] = {{"scalar", FILL_SCALAR}, {"sse2  ", FILL_SSE2}, {"avx2  ", FILL_AVX2}};
+  for (const auto &[name, kernel] : kernels) {
+    run((std::string("batch count_legal_moves ") + name).c_str(), positions.size(), rounds, [&, kernel = kernel] {
+      batch.count_legal_moves(counts, kernel);
+      long long n = 0;
+      for (int c : counts) n += c;
+      return n;
+    });
+  }
+  run("batch generate_legal          ", positions.size(), rounds, [&] {
+    batch.generate_legal(moves);
+    long long n = 0;
+    for (const auto &list : moves) n += list.size();
+    return n;
+  });
+  return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "attacks.hpp"
+
+// Set-wise bitboard fills shared by attack_info.cpp and position_batch.cpp. Every helper is a template
+// over the bitboard type: plain U64 for one board, or a GCC vector of two or four boards (one SSE2 or
+// AVX2 register), so one source builds the scalar and both SIMD kernels. They take and return vectors
+// by value and are force-inlined into the kernel entry points (the AVX2 one compiled for AVX2). GCC
+// still emits -Wpsabi notes for such signatures, so the files that include this header are built with
+// -Wno-psabi (src/CMakeLists.txt).
+
+#define FILL_INLINE inline __attribute__((always_inline))
+
+namespace chess {
+namespace fill {
+
+// Two and four boards per step; plain U64 is the one-board scalar step
+using U64x2 = U64 __attribute__((vector_size(16)));
+using U64x4 = U64 __attribute__((vector_size(32)));
+
+template <class V> constexpr int lane_count = sizeof(V) / sizeof(U64);
+
+inline constexpr U64 FILE_B = FILE_A << 1;
+inline constexpr U64 FILE_G = FILE_H >> 1;
+
+template <class V> FILL_INLINE V load(const U64 *p) {
+  V v;
+  __builtin_memcpy(&v, p, sizeof(V));
+  return v;
+}
+
+template <class V> FILL_INLINE void store(U64 *p, V v) { __builtin_memcpy(p, &v, sizeof(V)); }
+
+template <int Dir, class V> FILL_INLINE V shift(V b) {
+  if constexpr (Dir > 0) return b << Dir;
+  else return b >> -Dir;
+}
+
+// Squares a one-step shift in direction Dir may land on without wrapping around the board edge.
+template <int Dir> constexpr U64 dir_mask() {
+  if constexpr (Dir == 1 || Dir == 9 || Dir == -7) return ~FILE_A;
+  else if constexpr (Dir == -1 || Dir == -9 || Dir == 7) return ~FILE_H;
+  else return ~0ULL;
+}
+
+// Kogge-Stone occluded fill: gen spreads along Dir through the empty squares in pro in three doubling
+// steps (1, 2, 4); the final one-step shift adds the first blocker on each ray. Gives the attacks of
+// every slider in gen in that direction at once.
+template <int Dir, class V> FILL_INLINE V occluded_fill(V gen, V pro) {
+  constexpr U64 mask = dir_mask<Dir>();
+  pro &= mask;
+  gen |= pro & shift<Dir>(gen);
+  pro &= shift<Dir>(pro);
+  gen |= pro & shift<2 * Dir>(gen);
+  pro &= shift<2 * Dir>(pro);
+  gen |= pro & shift<4 * Dir>(gen);
+  return shift<Dir>(gen) & mask;
+}
+
+// Knight jump Dir from every square of b. One jump per call, so counts over the jumps are exact.
+template <int Dir, class V> FILL_INLINE V jump(V b) {
+  constexpr U64 mask = (Dir == 17 || Dir == -15) ? ~FILE_A
+                     : (Dir == 15 || Dir == -17) ? ~FILE_H
+                     : (Dir == 10 || Dir == -6)  ? ~(FILE_A | FILE_B)
+                     :                             ~(FILE_G | FILE_H);
+  return shift<Dir>(b) & mask;
+}
+
+// All knight attacks of a set
+template <class V> FILL_INLINE V knight_fill(V b) {
+  return jump<17>(b) | jump<15>(b) | jump<10>(b) | jump<6>(b) |
+         jump<-6>(b) | jump<-10>(b) | jump<-15>(b) | jump<-17>(b);
+}
+
+} // namespace fill
+} // namespace chess
@@ -0,0 +1,55 @@
+#include "cpu.hpp"
+
+namespace chess {
+
+namespace {
+
+CpuFeatures detect_cpu_features() {
+  CpuFeatures f;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  __builtin_cpu_init();
+  f.popcnt = __builtin_cpu_supports("popcnt");
+  f.bmi2 = __builtin_cpu_supports("bmi2");
+  f.fast_pext = f.bmi2 && !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+  f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+  return f;
+}
+
+} // namespace
+
+const CpuFeatures &cpu_features() {
+  static const CpuFeatures features = detect_cpu_features();
+  return features;
+}
+
+bool use_hw_popcnt = cpu_features().popcnt;
+bool use_pext_sliders = cpu_features().fast_pext;
+bool use_avx2_fills = cpu_features().avx2;
+
+std::string cpu_kernel_summary() {
+  std::string out;
+#if defined(__POPCNT__)
+  out += "popcnt=hw(static)";
+#else
+  out += use_hw_popcnt ? "popcnt=hw" : "popcnt=sw";
+#endif
+#if defined(__BMI__)
+  out += " ctz=tzcnt";
+#else
+  out += " ctz=bsf";
+#endif
+#if defined(__BMI2__)
+  out += " sliders=pext(static)";
+#else
+  out += use_pext_sliders ? " sliders=pext" : " sliders=magic";
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+  out += use_avx2_fills ? " fills=avx2" : " fills=sse2";
+#else
+  out += " fills=scalar";
+#endif
+  return out;
+}
+
+} // namespace chess
@@ -9,7 +9,6 @@ Game::Game(PlayerType white_player, PlayerType black_player)
         : position_(),
             movegen_(position_),
             selected_square_(std::nullopt),
-            attack_tables_init_(),
             status_(GameStatus::PLAYING),
             evaluation_engine_(std::make_unique<PositionEngine>()),
             base_fen_("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") {
@@ -44,9 +43,9 @@ bool Game::try_move(int from, int to, int promo) {
 
     // Check if move is in cached legal moves
     for (const auto& m : legal_moves_) {
-        if (m.from == from && m.to == to && (promo == 0 || m.promo == promo)) {
+        if (m.from() == from && m.to() == to && (promo == 0 || m.promo() == promo)) {
             // Move is legal, apply it
-            auto info = position_.apply_move(m.from, m.to, m.promo);
+            auto info = position_.apply_move(m.from(), m.to(), m.promo());
             if (!info) return false;
             
             last_move_from_ = from;
@@ -65,8 +64,8 @@ bool Game::try_move(int from, int to, int promo) {
             move_notation += to_rank;
             
             // Add promotion piece if applicable
-            if (m.promo != 0) {
-                switch (m.promo) {
+            if (m.promo() != 0) {
+                switch (m.promo()) {
                     case 1: move_notation += 'n'; break;  // Knight
                     case 2: move_notation += 'b'; break;  // Bishop
                     case 3: move_notation += 'r'; break;  // Rook
@@ -98,7 +97,7 @@ bool Game::try_move(int from, int to, int promo) {
 bool Game::is_promotion_move(int from, int to) const {
     // Check if this move is a pawn promotion
     for (const auto& m : legal_moves_) {
-        if (m.from == from && m.to == to && m.promo != 0) {
+        if (m.from() == from && m.to() == to && m.promo() != 0) {
             return true;
         }
     }
@@ -110,9 +109,9 @@ bool Game::apply_move(int from, int to, int promo) {
 
     // Check if move is in cached legal moves
     for (const auto& m : legal_moves_) {
-        if (m.from == from && m.to == to && (promo == 0 || m.promo == promo)) {
+        if (m.from() == from && m.to() == to && (promo == 0 || m.promo() == promo)) {
             // Move is legal, apply it
-            auto info = position_.apply_move(m.from, m.to, m.promo);
+            auto info = position_.apply_move(m.from(), m.to(), m.promo());
             if (!info) return false;
             
             last_move_from_ = from;
@@ -131,8 +130,8 @@ bool Game::apply_move(int from, int to, int promo) {
             move_notation += to_rank;
             
             // Add promotion piece if applicable
-            if (m.promo != 0) {
-                switch (m.promo) {
+            if (m.promo() != 0) {
+                switch (m.promo()) {
                     case 1: move_notation += 'n'; break;  // Knight
                     case 2: move_notation += 'b'; break;  // Bishop
                     case 3: move_notation += 'r'; break;  // Rook
@@ -179,7 +178,8 @@ void Game::update_status() {
 }
 
 void Game::update_legal_moves() {
-    legal_moves_ = chess::get_legal_moves(position_);
+    auto moves = chess::get_legal_moves(position_);
+    legal_moves_.assign(moves.begin(), moves.end());
 }
 
 void Game::update_repetition_history() {
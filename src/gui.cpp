@@ -87,7 +87,7 @@ void GUI::run() {
                         std::cerr << "[GUI] Engine returned move " << format_move_for_log(best_move_eval->move) << std::endl;
                         
                         // Apply the move
-                        bool moved = game_->apply_move(best_move_eval->move.from, best_move_eval->move.to, best_move_eval->move.promo);
+                        bool moved = game_->apply_move(best_move_eval->move.from(), best_move_eval->move.to(), best_move_eval->move.promo());
                         if (!moved) {
                             std::cerr << "[GUI] ERROR: Failed to apply move from engine!" << std::endl;
                         }
@@ -147,8 +147,8 @@ void GUI::draw_board(sf::RenderWindow& window) {
     if (selected_square_) {
         const auto& legal_moves = game_->get_legal_moves();
         for (const auto& move : legal_moves) {
-            if (move.from == *selected_square_) {
-                valid_destinations.push_back(move.to);
+            if (move.from() == *selected_square_) {
+                valid_destinations.push_back(move.to());
             }
         }
     }
@@ -321,10 +321,10 @@ void GUI::handle_events(sf::RenderWindow& window) {
                 if (game_->get_current_player_type() == PlayerType::HUMAN) {
                     MoveEvaluation eval = game_->get_best_move_suggestion();
                     std::cout << "Best move suggestion: " 
-                              << char('a' + (eval.move.from % 8)) << (1 + eval.move.from / 8) << "-"
-                              << char('a' + (eval.move.to % 8)) << (1 + eval.move.to / 8);
-                    if (eval.move.promo) {
-                        std::cout << " (promo to " << eval.move.promo << ")";
+                              << char('a' + (eval.move.from() % 8)) << (1 + eval.move.from() / 8) << "-"
+                              << char('a' + (eval.move.to() % 8)) << (1 + eval.move.to() / 8);
+                    if (eval.move.promo()) {
+                        std::cout << " (promo to " << eval.move.promo() << ")";
                     }
                     std::cout << ", Score: " << eval.score << std::endl;
                 } else {
@@ -1,22 +1,25 @@
 #include "material_engine.hpp"
 #include "search.hpp"
+#include "movepick.hpp"
+#include "cpu.hpp"
 #include <limits>
 #include <optional>
 #include <random>
 #include <vector>
 #include <chrono>
 #include <iostream>
+#include <algorithm>
 
 namespace chess {
 
 static std::string move_to_uci(const Move& move) {
     std::string out;
-    out += static_cast<char>('a' + (move.from % 8));
-    out += static_cast<char>('1' + (move.from / 8));
-    out += static_cast<char>('a' + (move.to % 8));
-    out += static_cast<char>('1' + (move.to / 8));
-    if (move.promo != 0) {
-        switch (move.promo) {
+    out += static_cast<char>('a' + (move.from() % 8));
+    out += static_cast<char>('1' + (move.from() / 8));
+    out += static_cast<char>('a' + (move.to() % 8));
+    out += static_cast<char>('1' + (move.to() / 8));
+    if (move.promo() != 0) {
+        switch (move.promo()) {
             case 1: out += 'n'; break;
             case 2: out += 'b'; break;
             case 3: out += 'r'; break;
@@ -52,7 +55,8 @@ bool MaterialEngine::should_stop_search() {
 }
 
 MoveEvaluation MaterialEngine::get_best_move(const Position& position, int depth, long long movetime_ms) {
-    int max_depth = std::max(1, depth);
+    // The search path's keys live in path_keys_, MAX_PLY deep
+    int max_depth = std::clamp(depth, 1, MAX_PLY - 1);
 
     use_time_limit_ = movetime_ms > 0;
     timed_out_ = false;
@@ -66,6 +70,7 @@ MoveEvaluation MaterialEngine::get_best_move(const Position& position, int depth
     if (legal_moves.empty()) {
         return MoveEvaluation{Move{0, 0, 0}, 0};
     }
+    order_moves(root_copy, legal_moves);
 
     // Keep last fully completed depth result as the return value.
     MoveEvaluation best_completed{legal_moves[0], 0};
@@ -83,8 +88,7 @@ MoveEvaluation MaterialEngine::get_best_move(const Position& position, int depth
         int beta = std::numeric_limits<int>::max();
 
         Position pos_copy = position;
-        auto search_history = position_history_;
-        search_history[get_position_hash(pos_copy)]++;
+        path_keys_[0] = get_position_hash(pos_copy);
 
         bool completed_depth = true;
         for (const Move& move : legal_moves) {
@@ -93,16 +97,14 @@ MoveEvaluation MaterialEngine::get_best_move(const Position& position, int depth
                 break;
             }
 
-            auto undo_info = pos_copy.apply_move(move.from, move.to, move.promo);
-            if (!undo_info) continue;
+            StateInfo st;
+            pos_copy.do_move(move, st);
+            path_keys_[1] = get_position_hash(pos_copy);
 
-            auto child_history = search_history;
-            child_history[get_position_hash(pos_copy)]++;
-
-            int opponent_score = alphabeta(pos_copy, d - 1, alpha, beta, child_history);
+            int opponent_score = alphabeta(pos_copy, d - 1, alpha, beta, 1);
             int score = -opponent_score;
 
-            pos_copy.undo_move(undo_info.value());
+            pos_copy.undo_move(move, st);
 
             if (timed_out_) {
                 completed_depth = false;
@@ -143,6 +145,10 @@ MoveEvaluation MaterialEngine::get_best_move(const Position& position, int depth
 }
 
 int MaterialEngine::evaluate(Position& position) {
+    return evaluate_node(position, has_legal_move(position));
+}
+
+int MaterialEngine::evaluate_node(Position& position, bool has_legal_moves) {
     // Piece value constants (centipawns)
     constexpr int PAWN_VALUE = 100;
     constexpr int KNIGHT_VALUE = 320;
@@ -161,13 +167,9 @@ int MaterialEngine::evaluate(Position& position) {
         }
     }
     
-    // Check for terminal positions
-    if (is_checkmate(position, side_to_move)) {
-        return std::numeric_limits<int>::min() + 1;
-    }
-    
-    if (is_stalemate(position, side_to_move)) {
-        return 0;
+    // Terminal positions: checkmate or stalemate
+    if (!has_legal_moves) {
+        return is_in_check(position, side_to_move) ? std::numeric_limits<int>::min() + 1 : 0;
     }
 
     if (position.halfmove_clock() >= 100) {
@@ -187,7 +189,7 @@ int MaterialEngine::evaluate(Position& position) {
         if (bb == 0) continue;
 
         if (piece != WK && piece != BK) {
-            int piece_count = __builtin_popcountll(bb);
+            int piece_count = popcount(bb);
             int piece_value = piece_values[piece];
 
             if (piece < 6) {
@@ -205,20 +207,15 @@ int MaterialEngine::evaluate(Position& position) {
     return score;
 }
 
-int MaterialEngine::alphabeta(Position& position, int depth, int alpha, int beta,
-                              std::unordered_map<uint64_t, int> position_history) {
+int MaterialEngine::alphabeta(Position& position, int depth, int alpha, int beta, int ply) {
     if (should_stop_search()) {
         return this->evaluate(position);
     }
 
     // Check threefold repetition at THIS depth in the search tree
     // Threefold repetition is automatic - game ends as a draw immediately
-    if (!position_history.empty()) {
-        uint64_t current_hash = get_position_hash(position);
-        auto it = position_history.find(current_hash);
-        if (it != position_history.end() && it->second >= 3) {
-            return 0;  // Threefold repetition: automatic draw
-        }
+    if (repetition_count(get_position_hash(position), ply) >= 3) {
+        return 0;  // Threefold repetition: automatic draw
     }
     
     // Check 50-move rule - can result in checkmate or draw
@@ -226,41 +223,38 @@ int MaterialEngine::alphabeta(Position& position, int depth, int alpha, int beta
         return this->evaluate(position);
     }
     
-    auto legal_moves = chess::get_legal_moves(position);
-    
-    // Terminal node (checkmate or stalemate) or depth limit
-    // Let evaluate() handle checkmate, stalemate, and 50-move rule
-    if (legal_moves.empty()) {
-        return this->evaluate(position);
-    }
-    
+    // Depth limit. Let evaluate() handle checkmate, stalemate, and 50-move rule
     if (depth == 0) {
         return this->evaluate(position);
     }
+
+    // Moves are generated stage by stage, so a cutoff skips the stages not reached yet
+    MovePicker picker(position);
     
     // Negamax always maximizes from current player's perspective
     // Recursive calls are negated because they return opponent's perspective
     int max_eval = std::numeric_limits<int>::min();
+    bool any_move = false;
     
-    for (const Move& move : legal_moves) {
+    for (Move move = picker.next_move(); move != Move(); move = picker.next_move()) {
+        any_move = true;
         if (should_stop_search()) {
             break;
         }
 
-        auto undo_info = position.apply_move(move.from, move.to, move.promo);
-        if (!undo_info) continue;
+        StateInfo st;
+        position.do_move(move, st);
         
-        // Track this position in the search history
-        auto child_history = position_history;
-        child_history[get_position_hash(position)]++;
+        // Track this position in the search path
+        path_keys_[ply + 1] = get_position_hash(position);
         
         // Negamax with alpha-beta: negate window for opponent's perspective
         // Safely handle extreme bounds to avoid integer overflow
         int neg_alpha = (beta == std::numeric_limits<int>::max()) ? std::numeric_limits<int>::min() : -beta;
         int neg_beta = (alpha == std::numeric_limits<int>::min()) ? std::numeric_limits<int>::max() : -alpha;
         
-        int eval = -alphabeta(position, depth - 1, neg_alpha, neg_beta, child_history);
-        position.undo_move(undo_info.value());
+        int eval = -alphabeta(position, depth - 1, neg_alpha, neg_beta, ply + 1);
+        position.undo_move(move, st);
 
         if (timed_out_) {
             break;
@@ -273,6 +267,11 @@ int MaterialEngine::alphabeta(Position& position, int depth, int alpha, int beta
             break; // Beta cutoff
         }
     }
+
+    // Terminal node (checkmate or stalemate): the picker already showed there is no legal move
+    if (!any_move) {
+        return evaluate_node(position, false);
+    }
     
     return max_eval;
 }
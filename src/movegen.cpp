@@ -3,248 +3,396 @@
 
 namespace chess {
 
-std::vector<Move> MoveGenerator::generate_pseudo_legal() {
-  std::vector<Move> moves;
-  moves.reserve(256);
-
-  add_pawn_moves(moves);
-  add_knight_moves(moves);
-  add_bishop_moves(moves);
-  add_rook_moves(moves);
-  add_queen_moves(moves);
-  add_king_moves(moves);
-  add_castling_moves(moves);
+namespace {
 
-  return moves;
+// Shift a whole bitboard by a square delta (positive = towards h8); bits leaving the board are dropped.
+template <int Delta>
+constexpr U64 shift(U64 b) {
+  if constexpr (Delta > 0) return b << Delta;
+  else return b >> -Delta;
 }
 
-// std::vector<Move> MoveGenerator::generate_captures() {
-//   std::vector<Move> moves;
-//   moves.reserve(128);
-
-//   add_pawn_moves(moves);
-//   add_knight_moves(moves);
-//   add_bishop_moves(moves);
-//   add_rook_moves(moves);
-//   add_queen_moves(moves);
-//   add_king_moves(moves);
-
-//   // Filter to captures only
-//   std::vector<Move> captures;
-//   for (const auto &m : moves) {
-//     if (is_capture(m.from, m.to)) {
-//       captures.push_back(m);
-//     }
-//   }
-//   return captures;
-// }
-
-void MoveGenerator::add_pawn_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  Color them = (us == WHITE) ? BLACK : WHITE;
-  int pawn_piece = (us == WHITE) ? WP : BP;
-  int forward = (us == WHITE) ? 8 : -8; // row direction
-  int rank_start = (us == WHITE) ? 8 : 48;    // starting rank (for double push)
-  int rank_promo = (us == WHITE) ? 56 : 7;    // promotion rank
-
-  U64 pawns = pos_.bitboard(static_cast<Piece>(pawn_piece));
-  U64 empty = ~pos_.occupied();
-  U64 them_occ = pos_.occupancy(them);
-  int ep_sq = pos_.en_passant_square();
+} // namespace
+
+U64 slider_blockers(const Position &pos, int sq, Color by, U64 blocker_occ) {
+  U64 occ = pos.occupied();
+  U64 queens = pos.bitboard(make_piece(by, QUEEN));
+  U64 snipers = (rook_attacks(sq, 0) & (pos.bitboard(make_piece(by, ROOK)) | queens)) |
+                (bishop_attacks(sq, 0) & (pos.bitboard(make_piece(by, BISHOP)) | queens));
+  U64 result = 0;
+  while (snipers) {
+    int sniper_sq = __builtin_ctzll(snipers);
+    snipers &= snipers - 1;
+    U64 blockers = between_bb[sq][sniper_sq] & occ;
+    if (blockers && !(blockers & (blockers - 1))) result |= blockers & blocker_occ;
+  }
+  return result;
+}
 
-  while (pawns) {
-    // Get index of least significant pawn and clear it from the bitboard
-    // This makes iterating over pawns efficient (no need to check all 64 squares).
-    int from = __builtin_ctzll(pawns);
-    pawns &= pawns - 1;
-
-    // Single push
-    int to = from + forward;
-    if (to >= 0 && to < 64 && (empty & (1ULL << to))) {
-      if ((to / 8) == (rank_promo / 8)) {
-        // Promotion
-        moves.emplace_back(from, to, 1); // N
-        moves.emplace_back(from, to, 2); // B
-        moves.emplace_back(from, to, 3); // R
-        moves.emplace_back(from, to, 4); // Q
-      } else {
-        moves.emplace_back(from, to, 0);
-      }
-
-      // Double push
-      if ((rank_start >> 3) == (from >> 3)) { // on starting rank
-        int to2 = from + 2 * forward; // to2's my word fam 
-        if (empty & (1ULL << to2)) {
-          moves.emplace_back(from, to2, 0);
-        }
-      }
-    }
+CheckInfo::CheckInfo(const Position &pos) {
+  Color us = pos.side_to_move();
+  Color them = ~us;
+  U64 their_king = pos.bitboard(make_piece(them, KING));
+  if (!their_king) return;
+  U64 occ = pos.occupied();
+  king_sq = __builtin_ctzll(their_king);
+  check_squares[PAWN] = pawn_attacks[them][king_sq];
+  check_squares[KNIGHT] = knight_attacks[king_sq];
+  check_squares[BISHOP] = bishop_attacks(king_sq, occ);
+  check_squares[ROOK] = rook_attacks(king_sq, occ);
+  check_squares[QUEEN] = check_squares[BISHOP] | check_squares[ROOK];
+  check_squares[KING] = 0;
+  discovered = slider_blockers(pos, king_sq, us, pos.occupancy(us));
+}
 
-    // Captures (diagonals)
-    for (int delta : {forward - 1, forward + 1}) {
-      int cap_sq = from + delta;
-      if (cap_sq >= 0 && cap_sq < 64 && (them_occ & (1ULL << cap_sq))) {
-        // Avoid wrapping off board (file boundary)
-        int f1 = from % 8, f2 = cap_sq % 8;
-        if ((delta == forward - 1 && f2 == f1 - 1) || (delta == forward + 1 && f2 == f1 + 1)) {
-          if ((cap_sq / 8) == (rank_promo / 8)) {
-            // Putting capture moves at the front of the list so they are considered first in search.
-            // This can improve alpha-beta search efficiency.
-            moves.emplace(moves.begin(), from, cap_sq, 1); // N
-            moves.emplace(moves.begin(), from, cap_sq, 2); // B
-            moves.emplace(moves.begin(), from, cap_sq, 3); // R
-            moves.emplace(moves.begin(), from, cap_sq, 4); // Q
-          } else {
-            moves.emplace(moves.begin(), from, cap_sq, 0);
-          }
-        }
-      }
+bool gives_check(const Position &pos, const CheckInfo &ci, Move m) {
+  Color us = pos.side_to_move();
+  int from = m.from();
+  int to = m.to();
+  U64 king = 1ULL << ci.king_sq;
+  PieceType pt = piece_type(static_cast<Piece>(pos.piece_on_square(from)));
+
+  // Direct check (promotions are handled below, as the new piece)
+  if (!m.is_promotion() && (ci.check_squares[pt] & (1ULL << to))) return true;
+
+  // Discovered check: a candidate leaving its line to the king
+  if ((ci.discovered & (1ULL << from)) && !(line_bb[ci.king_sq][from] & (1ULL << to))) return true;
+
+  if (!m.is_promotion() && !m.is_en_passant() && !m.is_castle()) return false;
+
+  U64 occ = (pos.occupied() ^ (1ULL << from)) | (1ULL << to);
+  if (m.is_promotion()) {
+    // The vacated from square can open the new piece's line to the king
+    switch (m.promo()) {
+      case 1: return knight_attacks[to] & king;
+      case 2: return bishop_attacks(to, occ) & king;
+      case 3: return rook_attacks(to, occ) & king;
+      default: return queen_attacks(to, occ) & king;
     }
+  }
+  if (m.is_en_passant()) {
+    // The captured pawn leaves the board too, which may uncover a slider on its line
+    occ ^= 1ULL << (to ^ 8);
+    U64 queens = pos.bitboard(make_piece(us, QUEEN));
+    return (bishop_attacks(ci.king_sq, occ) & (pos.bitboard(make_piece(us, BISHOP)) | queens)) ||
+           (rook_attacks(ci.king_sq, occ) & (pos.bitboard(make_piece(us, ROOK)) | queens));
+  }
+  // Castling: only the rook can give check, from its destination beside the king
+  int rook_from = (m.flags() == KING_CASTLE) ? from + 3 : from - 4;
+  int rook_to = (m.flags() == KING_CASTLE) ? from + 1 : from - 1;
+  occ = (pos.occupied() ^ (1ULL << from) ^ (1ULL << rook_from)) | (1ULL << to) | (1ULL << rook_to);
+  return rook_attacks(rook_to, occ) & king;
+}
 
-    // En passant
-    if (ep_sq >= 0) {
-      int delta = (us == WHITE) ? 7 : -7;
-      if (from + delta == ep_sq) {
-        int f1 = from % 8, f2 = ep_sq % 8;
-        if (std::abs(f1 - f2) == 1) {
-          moves.emplace(moves.begin(), from, ep_sq, 0); 
-        }
-      }
-      delta = (us == WHITE) ? 9 : -9;
-      if (from + delta == ep_sq) {
-        int f1 = from % 8, f2 = ep_sq % 8;
-        if (std::abs(f1 - f2) == 1) {
-          moves.emplace(moves.begin(), from, ep_sq, 0);
-        }
-      }
-    }
+template <GenType Type>
+MoveList MoveGenerator::generate() {
+  MoveList moves;
+  generate<Type>(moves);
+  return moves;
+}
+
+template <GenType Type>
+void MoveGenerator::generate(MoveList &moves) {
+  if (pos_.side_to_move() == WHITE) {
+    generate_for<WHITE, Type>(moves);
+  } else {
+    generate_for<BLACK, Type>(moves);
   }
 }
 
-void MoveGenerator::add_knight_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  int knight_piece = (us == WHITE) ? WN : BN;
-  U64 knights = pos_.bitboard(static_cast<Piece>(knight_piece));
-  U64 us_occ = pos_.occupancy(us);
-
-  while (knights) {
-    int from = __builtin_ctzll(knights);
-    knights &= knights - 1;
-    U64 targets = knight_attacks[from] & ~us_occ;
-
-    while (targets) {
-      int to = __builtin_ctzll(targets);
-      targets &= targets - 1;
-      // Place capture moves at the front of the moves list
-      if (is_capture(from, to)) {
-        moves.emplace(moves.begin(), from, to, 0);
-      } else {
-        moves.emplace_back(from, to, 0);
-      }
-    }
+template <Color Us>
+bool MoveGenerator::init_legality(bool legal, U64 &checkers) {
+  U64 king = pos_.bitboard(make_piece(Us, KING));
+
+  legal_ = legal;
+  pinned_ = 0;
+  target_mask_ = ~0ULL;
+  checkers = 0;
+  if (!king && legal_) return false;
+  king_sq_ = king ? __builtin_ctzll(king) : 0;
+
+  if (legal_) {
+    checkers = attackers_to<Us>(king_sq_, pos_.occupied());
+    pinned_ = slider_blockers(pos_, king_sq_, ~Us, pos_.occupancy(Us));
   }
+  return true;
 }
 
-void MoveGenerator::add_bishop_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  int bishop_piece = (us == WHITE) ? WB : BB;
-  U64 bishops = pos_.bitboard(static_cast<Piece>(bishop_piece));
+template <Color Us, GenType Type>
+void MoveGenerator::generate_for(MoveList &moves) {
+  constexpr Color them = ~Us;
+  U64 us_occ = pos_.occupancy(Us);
+  U64 occ = pos_.occupied();
+
+  U64 checkers;
+  if (!init_legality<Us>(Type != PSEUDO_LEGAL, checkers)) return;
 
-  static const std::vector<std::pair<int, int>> dirs = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-  add_sliding_moves(moves, bishops, dirs);
+  if constexpr (Type == QUIET_CHECKS) {
+    if (!pos_.bitboard(make_piece(them, KING))) return;
+    check_info_ = CheckInfo(pos_);
+  }
+
+  // Destination squares for this generation type
+  U64 targets = ~us_occ;
+  if (Type == CAPTURES) targets = pos_.occupancy(them);
+  if (Type == QUIETS || Type == QUIET_CHECKS) targets = ~occ;
+
+  // Double check: only the king can move
+  if (checkers & (checkers - 1)) {
+    add_king_moves<Us, Type>(moves, targets);
+    return;
+  }
+
+  // Single check: capture the checker or interpose (a knight or pawn check has nothing in between)
+  if (checkers) target_mask_ = checkers | between_bb[king_sq_][__builtin_ctzll(checkers)];
+
+  add_pawn_moves<Us, Type>(moves);
+  add_piece_moves<Us, Type, KNIGHT>(moves, targets);
+  add_piece_moves<Us, Type, BISHOP>(moves, targets);
+  add_piece_moves<Us, Type, ROOK>(moves, targets);
+  add_piece_moves<Us, Type, QUEEN>(moves, targets);
+  add_king_moves<Us, Type>(moves, targets);
+  if constexpr (Type == QUIETS || Type == LEGAL || Type == PSEUDO_LEGAL) {
+    if (!checkers) add_castling_moves<Us>(moves);
+  }
 }
 
-void MoveGenerator::add_rook_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  int rook_piece = (us == WHITE) ? WR : BR;
-  U64 rooks = pos_.bitboard(static_cast<Piece>(rook_piece));
+template MoveList MoveGenerator::generate<CAPTURES>();
+template MoveList MoveGenerator::generate<QUIETS>();
+template MoveList MoveGenerator::generate<QUIET_CHECKS>();
+template MoveList MoveGenerator::generate<EVASIONS>();
+template MoveList MoveGenerator::generate<LEGAL>();
+template MoveList MoveGenerator::generate<PSEUDO_LEGAL>();
+template void MoveGenerator::generate<CAPTURES>(MoveList &);
+template void MoveGenerator::generate<QUIETS>(MoveList &);
+template void MoveGenerator::generate<QUIET_CHECKS>(MoveList &);
+template void MoveGenerator::generate<EVASIONS>(MoveList &);
+template void MoveGenerator::generate<LEGAL>(MoveList &);
+template void MoveGenerator::generate<PSEUDO_LEGAL>(MoveList &);
+
+bool MoveGenerator::has_legal_move() {
+  return pos_.side_to_move() == WHITE ? has_legal_move_for<WHITE>() : has_legal_move_for<BLACK>();
+}
 
-  static const std::vector<std::pair<int, int>> dirs = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
-  add_sliding_moves(moves, rooks, dirs);
+template <Color Us>
+bool MoveGenerator::has_legal_move_for() {
+  U64 checkers;
+  if (!init_legality<Us>(true, checkers)) return false;
+
+  // King steps first: they are the only candidates in double check and the most likely to
+  // exist otherwise. Castling needs no look: a legal castle implies a legal step towards the rook.
+  MoveList moves;
+  U64 targets = ~pos_.occupancy(Us);
+  add_king_moves<Us, LEGAL>(moves, targets);
+  if (!moves.empty()) return true;
+  if (checkers & (checkers - 1)) return false;
+
+  if (checkers) target_mask_ = checkers | between_bb[king_sq_][__builtin_ctzll(checkers)];
+
+  add_piece_moves<Us, LEGAL, KNIGHT>(moves, targets);
+  if (!moves.empty()) return true;
+  add_piece_moves<Us, LEGAL, BISHOP>(moves, targets);
+  if (!moves.empty()) return true;
+  add_piece_moves<Us, LEGAL, ROOK>(moves, targets);
+  if (!moves.empty()) return true;
+  add_piece_moves<Us, LEGAL, QUEEN>(moves, targets);
+  if (!moves.empty()) return true;
+  add_pawn_moves<Us, LEGAL>(moves);
+  return !moves.empty();
 }
 
-void MoveGenerator::add_queen_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  int queen_piece = (us == WHITE) ? WQ : BQ;
-  U64 queens = pos_.bitboard(static_cast<Piece>(queen_piece));
+bool MoveGenerator::is_legal(Move m) {
+  from_mask_ = 1ULL << m.from();
+  MoveList moves;
+  generate<LEGAL>(moves);
+  from_mask_ = ~0ULL;
+  for (const auto &candidate : moves) {
+    if (candidate == m) return true;
+  }
+  return false;
+}
 
-  static const std::vector<std::pair<int, int>> dirs = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-  add_sliding_moves(moves, queens, dirs);
+template <Color Us, GenType Type>
+void MoveGenerator::add_pawn_moves(MoveList &moves) {
+  U64 pawns = pos_.bitboard(make_piece(Us, PAWN)) & from_mask_;
+
+  // Pinned pawns (and, for quiet checks, discovered-check candidates) each have their own target set;
+  // the rest share one and are generated together.
+  U64 single = pinned_;
+  if constexpr (Type == QUIET_CHECKS) single |= check_info_.discovered;
+  U64 push_targets = target_mask_;
+  if constexpr (Type == QUIET_CHECKS) push_targets &= check_info_.check_squares[PAWN];
+  add_pawn_set<Us, Type>(moves, pawns & ~single, target_mask_, push_targets);
+
+  single &= pawns;
+  while (single) {
+    int from = __builtin_ctzll(single);
+    single &= single - 1;
+    U64 allowed = legal_targets(from);
+    U64 push_allowed = allowed;
+    if constexpr (Type == QUIET_CHECKS) push_allowed &= check_targets(PAWN, from);
+    add_pawn_set<Us, Type>(moves, 1ULL << from, allowed, push_allowed);
+  }
+
+  // En passant. Legality is checked by occupancy rather than the target mask: the captured pawn may be
+  // the checker, and removing two pawns from one rank can expose the king to a rook or queen along it.
+  int ep_sq = pos_.en_passant_square();
+  if (Type == QUIETS || Type == QUIET_CHECKS || ep_sq < 0) return;
+  int victim = ep_sq - ((Us == WHITE) ? 8 : -8);
+  U64 ep_pawns = pawn_attacks[~Us][ep_sq] & pawns;
+  while (ep_pawns) {
+    int from = __builtin_ctzll(ep_pawns);
+    ep_pawns &= ep_pawns - 1;
+    if (legal_) {
+      U64 after = (pos_.occupied() ^ (1ULL << from) ^ (1ULL << victim)) | (1ULL << ep_sq);
+      if (attackers_to<Us>(king_sq_, after) & ~(1ULL << victim)) continue;
+    }
+    moves.push_back(Move::make(from, ep_sq, EP_CAPTURE));
+  }
 }
 
-void MoveGenerator::add_king_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  int king_piece = (us == WHITE) ? WK : BK;
-  U64 king = pos_.bitboard(static_cast<Piece>(king_piece));
-  U64 us_occ = pos_.occupancy(us);
+template <Color Us, GenType Type>
+void MoveGenerator::add_pawn_set(MoveList &moves, U64 pawns, U64 allowed, U64 push_allowed) {
+  // Captures and promotions belong to the tactical stage, plain pushes to the quiet ones
+  constexpr bool tactical = (Type != QUIETS && Type != QUIET_CHECKS);
+  constexpr bool quiet = (Type != CAPTURES);
 
-  if (!king) return;
-  int from = __builtin_ctzll(king);
-  U64 targets = king_attacks[from] & ~us_occ;
+  constexpr int up = (Us == WHITE) ? 8 : -8;
+  constexpr U64 promo_rank = (Us == WHITE) ? RANK_8 : RANK_1;
+  constexpr U64 double_rank = (Us == WHITE) ? RANK_3 : RANK_6; // where a pawn lands after its first single push
+  U64 empty = ~pos_.occupied();
+  U64 enemies = pos_.occupancy(~Us);
+
+  U64 pushes = shift<up>(pawns) & empty;
+  if (quiet) {
+    // The double push is taken from the unmasked single pushes: a pin or check may rule out one but not the other
+    U64 doubles = shift<up>(pushes & double_rank) & empty & push_allowed;
+    add_pawn_targets(moves, pushes & ~promo_rank & push_allowed, up, QUIET);
+    add_pawn_targets(moves, doubles, 2 * up, DOUBLE_PUSH);
+  }
+  if (tactical) {
+    // Diagonal captures; the file masks stop a-file pawns wrapping to the h-file and vice versa
+    U64 west = shift<up - 1>(pawns & ~FILE_A) & enemies & allowed;
+    U64 east = shift<up + 1>(pawns & ~FILE_H) & enemies & allowed;
+    add_pawn_promotions(moves, pushes & promo_rank & allowed, up, PROMOTION);
+    add_pawn_promotions(moves, west & promo_rank, up - 1, PROMO_CAPTURE);
+    add_pawn_promotions(moves, east & promo_rank, up + 1, PROMO_CAPTURE);
+    add_pawn_targets(moves, west & ~promo_rank, up - 1, CAPTURE);
+    add_pawn_targets(moves, east & ~promo_rank, up + 1, CAPTURE);
+  }
+}
 
+void MoveGenerator::add_pawn_targets(MoveList &moves, U64 targets, int delta, int flags) {
   while (targets) {
     int to = __builtin_ctzll(targets);
     targets &= targets - 1;
-    if (is_capture(from, to)) {
-      moves.emplace(moves.begin(), from, to, 0);
-    } else {
-      moves.emplace_back(from, to, 0);
-    }
+    moves.push_back(Move::make(to - delta, to, flags));
   }
 }
 
-void MoveGenerator::add_castling_moves(std::vector<Move> &moves) {
-  Color us = pos_.side_to_move();
-  int castling = pos_.castling_rights();
-  U64 occ = pos_.occupied();
-
-  if (us == WHITE) {
-    // King-side
-    if ((castling & 1) && !(occ & 0x60ULL)) { // e1, f1, g1 free
-      moves.emplace_back(4, 6, 0);
-    }
-    // Queen-side
-    if ((castling & 2) && !(occ & 0x0EULL)) { // a1, b1, c1, d1 free
-      moves.emplace_back(4, 2, 0);
-    }
-  } else {
-    // King-side
-    if ((castling & 4) && !(occ & 0x6000000000000000ULL)) {
-      moves.emplace_back(60, 62, 0);
-    }
-    // Queen-side
-    if ((castling & 8) && !(occ & 0x0E00000000000000ULL)) {
-      moves.emplace_back(60, 58, 0);
-    }
+void MoveGenerator::add_pawn_promotions(MoveList &moves, U64 targets, int delta, int flags) {
+  while (targets) {
+    int to = __builtin_ctzll(targets);
+    targets &= targets - 1;
+    moves.push_back(Move::make(to - delta, to, flags | 0)); // N
+    moves.push_back(Move::make(to - delta, to, flags | 1)); // B
+    moves.push_back(Move::make(to - delta, to, flags | 2)); // R
+    moves.push_back(Move::make(to - delta, to, flags | 3)); // Q
   }
 }
 
-void MoveGenerator::add_sliding_moves(std::vector<Move> &moves, U64 pieces, const std::vector<std::pair<int, int>> &directions) {
-  Color us = pos_.side_to_move();
-  Color them = (us == WHITE) ? BLACK : WHITE;
-  U64 us_occ = pos_.occupancy(us);
-  U64 them_occ = pos_.occupancy(them);
+template <Color Us, GenType Type, PieceType Pt>
+void MoveGenerator::add_piece_moves(MoveList &moves, U64 targets) {
+  U64 pieces = pos_.bitboard(make_piece(Us, Pt)) & from_mask_;
+  U64 occ = pos_.occupied();
 
   while (pieces) {
     int from = __builtin_ctzll(pieces);
     pieces &= pieces - 1;
-    int f = from % 8, r = from >> 3;
-
-    for (auto [df, dr] : directions) {
-      for (int dist = 1; dist < 8; ++dist) {
-        int nf = f + dist * df;
-        int nr = r + dist * dr;
-        if (nf < 0 || nf > 7 || nr < 0 || nr > 7) break;
-        int to = nr * 8 + nf;
-
-        if (us_occ & (1ULL << to)) break; // blocked by own piece
-        if (them_occ & (1ULL << to)) {
-          moves.emplace(moves.begin(), from, to, 0); // capture move at front
-          break;
-        }
-        moves.emplace_back(from, to, 0); // otherwise nothing blocking, emplace at back and continue sliding
-      }
+    U64 attacks;
+    if constexpr (Pt == KNIGHT) attacks = knight_attacks[from];
+    else if constexpr (Pt == BISHOP) attacks = bishop_attacks(from, occ);
+    else if constexpr (Pt == ROOK) attacks = rook_attacks(from, occ);
+    else attacks = queen_attacks(from, occ);
+
+    U64 to = attacks & targets & legal_targets(from);
+    if constexpr (Type == QUIET_CHECKS) to &= check_targets(Pt, from);
+    add_moves_from(moves, from, to);
+  }
+}
+
+template <Color Us, GenType Type>
+void MoveGenerator::add_king_moves(MoveList &moves, U64 targets) {
+  if (!(pos_.bitboard(make_piece(Us, KING)) & from_mask_)) return;
+  targets &= king_attacks[king_sq_];
+  if constexpr (Type == QUIET_CHECKS) targets &= check_targets(KING, king_sq_);
+
+  if (!legal_) {
+    add_moves_from(moves, king_sq_, targets);
+    return;
+  }
+
+  // Lift the king off the board so squares behind it on a checking slider's ray count as attacked
+  U64 occ = pos_.occupied() ^ (1ULL << king_sq_);
+  for (U64 to = targets; to; to &= to - 1) {
+    if (attackers_to<Us>(__builtin_ctzll(to), occ)) targets &= ~(to & -to);
+  }
+  add_moves_from(moves, king_sq_, targets);
+}
+
+template <Color Us>
+void MoveGenerator::add_castling_moves(MoveList &moves) {
+  // King and rook squares mirror between the colors: the black ones are the white ones shifted up 7 ranks
+  constexpr int base = (Us == WHITE) ? 0 : 56;
+  constexpr int king_side = (Us == WHITE) ? 1 : 4;
+  constexpr int queen_side = (Us == WHITE) ? 2 : 8;
+  constexpr int king_sq = base + 4;
+  int castling = pos_.castling_rights();
+  U64 occ = pos_.occupied();
+  if (!(from_mask_ & (1ULL << king_sq))) return;
+
+  // In legal mode the king is known not to be in check; it also may not cross or land on an attacked square
+  auto safe = [&](U64 path) {
+    if (!legal_) return true;
+    for (; path; path &= path - 1) {
+      if (attackers_to<Us>(__builtin_ctzll(path), occ)) return false;
     }
+    return true;
+  };
+
+  // The rook's path to the king must be empty; the king's own path (its destination included) must be safe
+  if ((castling & king_side) && !(occ & between_bb[king_sq][base + 7]) &&
+      safe(between_bb[king_sq][base + 6] | (1ULL << (base + 6)))) {
+    moves.push_back(Move::make(king_sq, base + 6, KING_CASTLE));
+  }
+  if ((castling & queen_side) && !(occ & between_bb[king_sq][base]) &&
+      safe(between_bb[king_sq][base + 2] | (1ULL << (base + 2)))) {
+    moves.push_back(Move::make(king_sq, base + 2, QUEEN_CASTLE));
+  }
+}
+
+U64 MoveGenerator::legal_targets(int from) const {
+  if (pinned_ & (1ULL << from)) return target_mask_ & line_bb[king_sq_][from];
+  return target_mask_;
+}
+
+U64 MoveGenerator::check_targets(PieceType pt, int from) const {
+  // A discovered-check candidate gives check from anywhere off its line to the enemy king
+  const CheckInfo &ci = check_info_;
+  if (ci.discovered & (1ULL << from)) return ci.check_squares[pt] | ~line_bb[ci.king_sq][from];
+  return ci.check_squares[pt];
+}
+
+template <Color Us>
+U64 MoveGenerator::attackers_to(int sq, U64 occ) const {
+  return pos_.attackers_to(sq, occ) & pos_.occupancy(~Us);
+}
+
+void MoveGenerator::add_moves_from(MoveList &moves, int from, U64 targets) {
+  while (targets) {
+    int to = __builtin_ctzll(targets);
+    targets &= targets - 1;
+    moves.push_back(Move::make(from, to, is_capture(from, to) ? CAPTURE : QUIET));
   }
 }
 
@@ -0,0 +1,95 @@
+#include "movepick.hpp"
+#include "search.hpp"
+#include "see.hpp"
+
+namespace chess {
+
+MovePicker::MovePicker(const Position &pos, Move hash_move)
+    : pos_(pos), gen_(pos), hash_move_(hash_move), stage_(HASH_MOVE) {}
+
+bool MovePicker::is_good_capture(Move m) const {
+  if (m.is_promotion()) {
+    if (m.promo() != 4) return false; // underpromotions, capturing or not, go last
+    if (!m.is_capture()) return true;
+  }
+  return see_ge(pos_, m, 0);
+}
+
+Move MovePicker::next_move() {
+  while (true) {
+    switch (stage_) {
+    case HASH_MOVE: {
+      U64 king = pos_.bitboard((pos_.side_to_move() == WHITE) ? WK : BK);
+      bool in_check = king && pos_.is_square_attacked(__builtin_ctzll(king),
+                                                      static_cast<Color>(pos_.side_to_move() ^ 1));
+      stage_ = in_check ? EVASIONS_INIT : CAPTURES_INIT;
+      if (hash_move_ != Move() && gen_.is_legal(hash_move_)) return hash_move_;
+      hash_move_ = Move();
+      break;
+    }
+
+    case CAPTURES_INIT:
+      moves_.clear();
+      gen_.generate<CAPTURES>(moves_);
+      order_moves(pos_, moves_);
+      cur_ = 0;
+      stage_ = GOOD_CAPTURES;
+      break;
+
+    case GOOD_CAPTURES:
+      while (cur_ < moves_.size()) {
+        Move m = moves_[cur_++];
+        if (m == hash_move_) continue;
+        if (!is_good_capture(m)) {
+          bad_captures_.push_back(m);
+          continue;
+        }
+        return m;
+      }
+      stage_ = QUIETS_INIT;
+      break;
+
+    case QUIETS_INIT:
+      moves_.clear();
+      gen_.generate<QUIETS>(moves_);
+      cur_ = 0;
+      stage_ = QUIET_MOVES;
+      break;
+
+    case QUIET_MOVES:
+      while (cur_ < moves_.size()) {
+        Move m = moves_[cur_++];
+        if (m != hash_move_) return m;
+      }
+      cur_ = 0;
+      stage_ = BAD_CAPTURES;
+      break;
+
+    case BAD_CAPTURES:
+      if (cur_ < bad_captures_.size()) return bad_captures_[cur_++];
+      stage_ = DONE;
+      break;
+
+    case EVASIONS_INIT:
+      moves_.clear();
+      gen_.generate<EVASIONS>(moves_);
+      order_moves(pos_, moves_);
+      cur_ = 0;
+      stage_ = EVASION_MOVES;
+      break;
+
+    case EVASION_MOVES:
+      while (cur_ < moves_.size()) {
+        Move m = moves_[cur_++];
+        if (m != hash_move_) return m;
+      }
+      stage_ = DONE;
+      break;
+
+    case DONE:
+      return Move();
+    }
+  }
+}
+
+} // namespace chess
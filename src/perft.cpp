@@ -0,0 +1,290 @@
+#include "perft.hpp"
+#include "attacks.hpp"
+#include "zobrist.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace chess {
+
+namespace {
+
+// Subtrees at least this deep are split into their children when a worker is idle; smaller ones
+// finish faster than the split costs.
+constexpr int SPLIT_DEPTH = 4;
+
+// Before the workers start, expand the root breadth-first until there are this many tasks per thread
+constexpr int TASKS_PER_THREAD = 8;
+
+struct PerftTask {
+  Position pos;   // subtree root
+  int depth;      // plies left below pos
+  int root_index; // root move the subtree belongs to
+};
+
+// Perft table slot. Mixing the depth into the key keeps one position's subtrees at different depths
+// from evicting each other.
+std::size_t slot(U64 key, int depth, std::size_t mask) {
+  return (key ^ (static_cast<U64>(depth) * 0x9E3779B97F4A7C15ULL)) & mask;
+}
+
+class PerftPool {
+public:
+  PerftPool(int threads, PerftMode mode, PerftTable *table, int root_moves)
+      : mode_(mode), table_(mode == PERFT_BULK ? table : nullptr), results_(threads, std::vector<PerftStats>(root_moves)) {
+    for (int i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+  }
+
+  // Initial tasks are dealt round-robin
+  void add(PerftTask task) {
+    queues_[next_++ % queues_.size()]->tasks.push_back(std::move(task));
+    ++pending_;
+  }
+
+  // Run every task to completion; returns the stats per root move
+  std::vector<PerftStats> run() {
+    std::vector<std::thread> workers;
+    for (std::size_t id = 1; id < queues_.size(); ++id) workers.emplace_back(&PerftPool::work, this, id);
+    work(0);
+    for (auto &t : workers) t.join();
+
+    std::vector<PerftStats> total = results_[0];
+    for (std::size_t id = 1; id < results_.size(); ++id) {
+      for (std::size_t i = 0; i < total.size(); ++i) total[i] += results_[id][i];
+    }
+    return total;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<PerftTask> tasks;
+  };
+
+  // Own queue newest first (depth-first, cache-warm); steal the oldest task, usually the largest
+  bool pop(std::size_t id, PerftTask &out) {
+    {
+      Queue &own = *queues_[id];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        out = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+      Queue &victim = *queues_[(id + k) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(std::size_t id) {
+    Position pos; // this worker's board
+    PerftTask task;
+    uint64_t seen = 0; // splits_ when this worker last looked for a task
+    for (;;) {
+      if (!pop(id, task)) {
+        // Sleep until a split queues new tasks or the last task finishes. A split between the failed
+        // pop and taking the lock has already bumped splits_, so it is not missed.
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        if (pending_.load() == 0) return;
+        if (splits_ == seen) {
+          ++idle_;
+          wake_.wait(lock, [&] { return pending_.load() == 0 || splits_ != seen; });
+          --idle_;
+        }
+        seen = splits_;
+        continue;
+      }
+
+      pos = task.pos;
+      if (task.depth >= SPLIT_DEPTH && idle_.load() > 0) {
+        // Hand the children to the idle workers through this worker's queue. A subtree of depth >= 2
+        // is exactly the sum of its children's subtrees, so the split does not change any count.
+        MoveList moves = MoveGenerator(pos).generate_legal();
+        {
+          Queue &own = *queues_[id];
+          std::lock_guard<std::mutex> lock(own.mutex);
+          for (const auto &m : moves) {
+            StateInfo st;
+            pos.do_move(m, st);
+            own.tasks.push_back(PerftTask{pos, task.depth - 1, task.root_index});
+            pos.undo_move(m, st);
+          }
+          pending_ += moves.size();
+        }
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        ++splits_;
+        wake_.notify_all();
+      } else if (table_) {
+        results_[id][task.root_index].nodes += perft_hashed(pos, task.depth, *table_);
+      } else {
+        results_[id][task.root_index] += perft(pos, task.depth, mode_);
+      }
+      if (--pending_ == 0) {
+        // Last task done: wake the sleeping workers so they exit
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_.notify_all();
+      }
+    }
+  }
+
+  PerftMode mode_;
+  PerftTable *table_; // shared by all workers; null unless counting nodes only
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::vector<PerftStats>> results_; // [worker][root move], merged after the run
+  std::atomic<int> pending_{0};                  // tasks queued or running
+  std::atomic<int> idle_{0};                     // workers asleep on wake_
+  std::mutex wake_mutex_;                        // guards splits_ and the wait on wake_
+  std::condition_variable wake_;                 // signalled on every split and when pending_ hits 0
+  uint64_t splits_ = 0;                          // number of splits so far
+  std::size_t next_ = 0;
+};
+
+} // namespace
+
+PerftTable::PerftTable(std::size_t mb) {
+  // Largest power of two number of entries that fits in the budget (at least one)
+  std::size_t count = std::max<std::size_t>(1, mb * 1024 * 1024 / sizeof(Entry));
+  std::size_t entries = 1;
+  while (entries * 2 <= count) entries *= 2;
+  entries_ = std::make_unique<Entry[]>(entries);
+  mask_ = entries - 1;
+}
+
+bool PerftTable::probe(U64 key, int depth, uint64_t &nodes) const {
+  const Entry &e = entries_[slot(key, depth, mask_)];
+  U64 data = e.data.load(std::memory_order_relaxed);
+  U64 check = e.check.load(std::memory_order_relaxed);
+  if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth) return false;
+  nodes = data >> 8;
+  return true;
+}
+
+void PerftTable::store(U64 key, int depth, uint64_t nodes) {
+  Entry &e = entries_[slot(key, depth, mask_)];
+  U64 data = (nodes << 8) | static_cast<U64>(depth);
+  e.check.store(key ^ data, std::memory_order_relaxed);
+  e.data.store(data, std::memory_order_relaxed);
+}
+
+void PerftTable::clear() {
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    entries_[i].check.store(0, std::memory_order_relaxed);
+    entries_[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+U64 perft_key(const Position &pos) {
+  U64 key = pos.key();
+  int ep = pos.en_passant_square();
+  Color us = pos.side_to_move();
+  if (ep >= 0 && (pawn_attacks[~us][ep] & pos.bitboard(make_piece(us, PAWN)))) {
+    key ^= zobrist::keys.en_passant[ep & 7];
+  }
+  return key;
+}
+
+uint64_t perft_hashed(Position &pos, int depth, PerftTable &table) {
+  if (depth <= 1) return perft_bulk(pos, depth);
+
+  U64 key = perft_key(pos);
+  uint64_t nodes = 0;
+  if (table.probe(key, depth, nodes)) return nodes;
+
+  for (const auto &m : MoveGenerator(pos).generate_legal()) {
+    StateInfo st;
+    pos.do_move(m, st);
+    nodes += perft_hashed(pos, depth - 1, table);
+    pos.undo_move(m, st);
+  }
+  table.store(key, depth, nodes);
+  return nodes;
+}
+
+std::vector<PerftDivide> perft_divide(const Position &pos, int depth, int threads, PerftMode mode,
+                                      PerftTable *table) {
+  Position root = pos;
+  MoveList moves = MoveGenerator(root).generate_legal();
+  std::vector<PerftDivide> divide;
+  if (depth <= 0) return divide;
+
+  // Expand the root breadth-first (keeping each subtree's root move) until every worker has enough
+  // tasks to start with, or the subtrees get too shallow to be worth splitting.
+  threads = std::max(1, threads);
+  std::vector<PerftTask> tasks;
+  for (int i = 0; i < moves.size(); ++i) {
+    divide.push_back(PerftDivide{moves[i], PerftStats()});
+    StateInfo st;
+    root.do_move(moves[i], st);
+    tasks.push_back(PerftTask{root, depth - 1, i});
+    root.undo_move(moves[i], st);
+  }
+  while (threads > 1 && tasks.size() < static_cast<std::size_t>(threads * TASKS_PER_THREAD) &&
+         !tasks.empty() && tasks.front().depth >= 2) {
+    std::vector<PerftTask> next;
+    for (auto &task : tasks) {
+      for (const auto &m : MoveGenerator(task.pos).generate_legal()) {
+        StateInfo st;
+        task.pos.do_move(m, st);
+        next.push_back(PerftTask{task.pos, task.depth - 1, task.root_index});
+        task.pos.undo_move(m, st);
+      }
+    }
+    tasks.swap(next);
+  }
+
+  PerftPool pool(threads, mode, table, moves.size());
+  for (auto &task : tasks) pool.add(std::move(task));
+  std::vector<PerftStats> stats = pool.run();
+  for (std::size_t i = 0; i < divide.size(); ++i) divide[i].stats = stats[i];
+  return divide;
+}
+
+PerftStats perft_parallel(const Position &pos, int depth, int threads, PerftMode mode, PerftTable *table) {
+  // Depth 1 stats describe the root moves themselves, which the subtrees below them do not carry
+  if (depth <= 1) {
+    Position root = pos;
+    return perft(root, depth, mode);
+  }
+  PerftStats total;
+  for (const auto &entry : perft_divide(pos, depth, threads, mode, table)) total += entry.stats;
+  return total;
+}
+
+bool parse_perft_epd(const std::string &line, PerftEpd &out) {
+  std::size_t start = line.find_first_not_of(" \t\r");
+  if (start == std::string::npos || line[start] == '#') return false;
+
+  std::size_t semi = line.find(';', start);
+  if (semi == start) return false;
+  std::size_t end = line.find_last_not_of(" \t\r", semi == std::string::npos ? std::string::npos : semi - 1);
+  out.fen = line.substr(start, end - start + 1);
+  out.expected.clear();
+
+  while (semi != std::string::npos) {
+    std::size_t next = line.find(';', semi + 1);
+    std::istringstream field(line.substr(semi + 1, next == std::string::npos ? std::string::npos : next - semi - 1));
+    std::string op;
+    uint64_t nodes = 0;
+    if (field >> op >> nodes && op.size() > 1 && op[0] == 'D') {
+      out.expected.emplace_back(std::atoi(op.c_str() + 1), nodes);
+    }
+    semi = next;
+  }
+  return true;
+}
+
+} // namespace chess
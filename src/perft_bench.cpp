@@ -0,0 +1,53 @@
+// Parallel perft scaling: nodes, time, nodes/sec and speedup over one thread, per thread count.
+// Usage: chess_perft_bench [depth] [max_threads] [full|bulk|hash] [fen]
+// Defaults to Kiwipete, depth 5, bulk counting, and powers of two up to the hardware thread count.
+// hash is bulk counting through a 256 MB perft table shared by the threads, cleared before each run.
+#include "perft.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace chess;
+
+int main(int argc, char* argv[]) {
+    int depth = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+    int max_threads = argc > 2 ? std::max(1, std::atoi(argv[2]))
+                               : std::max(1u, std::thread::hardware_concurrency());
+    PerftMode mode = (argc > 3 && std::strcmp(argv[3], "full") == 0) ? PERFT_FULL : PERFT_BULK;
+    std::unique_ptr<PerftTable> table;
+    if (argc > 3 && std::strcmp(argv[3], "hash") == 0) table = std::make_unique<PerftTable>(256);
+    std::string fen = argc > 4 ? argv[4] : "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+
+    Position pos;
+    std::string err;
+    if (!pos.set_from_fen(fen, &err)) {
+        std::cout << "bad FEN: " << err << std::endl;
+        return 1;
+    }
+
+    std::cout << "perft depth " << depth << (table ? " (hashed)" : mode == PERFT_BULK ? " (bulk)" : " (full stats)")
+              << " of " << fen << std::endl;
+    double base_time = 0;
+    uint64_t base_nodes = 0;
+    for (int threads = 1;; threads = std::min(threads * 2, max_threads)) {
+        if (table) table->clear();
+        auto start = std::chrono::steady_clock::now();
+        PerftStats stats = perft_parallel(pos, depth, threads, mode, table.get());
+        auto end = std::chrono::steady_clock::now();
+        double secs = std::chrono::duration<double>(end - start).count();
+        if (threads == 1) {
+            base_time = secs;
+            base_nodes = stats.nodes;
+        }
+        std::cout << "threads " << threads << ": " << stats.nodes << " nodes, " << secs << " s, "
+                  << static_cast<uint64_t>(stats.nodes / secs) << " nps, speedup " << base_time / secs
+                  << (stats.nodes == base_nodes ? "" : "  NODE COUNT MISMATCH") << std::endl;
+        if (threads == max_threads) break;
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Perft from the command line, one JSON object per line so runs can be collected and compared per commit.
+// Usage: chess_perft [--fen FEN | --epd FILE] [--depth N] [--threads N] [--mode full|bulk|hash]
+//                    [--hash MB] [--max-nodes N] [--divide] [--results FILE] [--min-nps N]
+// Defaults to the start position, depth 5, one thread and bulk counting; --threads 0 uses every core.
+// With --epd every position of the suite ("<fen> ;D1 20 ;D2 400 ...") runs at the deepest listed depth
+// up to --depth whose listed count is also at most --max-nodes, if given, and is checked against that
+// count; a position with no listed depth inside both limits is reported as skipped rather than run.
+// --divide adds one line per root move before each position's total. --results also appends the
+// position lines to FILE. --min-nps fails positions of at least a million nodes that ran slower.
+// Exits with 1 on a bad argument or FEN, 2 if any count differs from the EPD expectation or is too slow.
+#include "perft.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+std::string move_to_uci(const Move& move) {
+    std::string out;
+    out += static_cast<char>('a' + (move.from() % 8));
+    out += static_cast<char>('1' + (move.from() / 8));
+    out += static_cast<char>('a' + (move.to() % 8));
+    out += static_cast<char>('1' + (move.to() / 8));
+    if (move.is_promotion()) out += "nbrq"[move.promo() - 1];
+    return out;
+}
+
+// FENs and file names never need more than quotes and backslashes escaped
+std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+void print_stats(std::ostream& out, const PerftStats& stats, bool full) {
+    out << "\"nodes\":" << stats.nodes;
+    if (!full) return;
+    out << ",\"captures\":" << stats.captures << ",\"en_passants\":" << stats.en_passants
+        << ",\"castles\":" << stats.castles << ",\"promotions\":" << stats.promotions
+        << ",\"checks\":" << stats.checks << ",\"checkmates\":" << stats.checkmates;
+}
+
+void usage() {
+    std::cerr << "usage: chess_perft [--fen FEN | --epd FILE] [--depth N] [--threads N]"
+                 " [--mode full|bulk|hash] [--hash MB] [--max-nodes N] [--divide] [--results FILE] [--min-nps N]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string fen = START_FEN;
+    std::string epd_file;
+    int depth = 5;
+    int threads = 1;
+    std::string mode_name = "bulk";
+    int hash_mb = 256;
+    bool divide = false;
+    std::string results_file;
+    uint64_t min_nps = 0;
+    uint64_t max_nodes = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--divide") {
+            divide = true;
+        } else if (arg == "--fen" && has_value) {
+            fen = argv[++i];
+        } else if (arg == "--epd" && has_value) {
+            epd_file = argv[++i];
+        } else if (arg == "--depth" && has_value) {
+            depth = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && has_value) {
+            threads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--mode" && has_value) {
+            mode_name = argv[++i];
+        } else if (arg == "--hash" && has_value) {
+            hash_mb = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--results" && has_value) {
+            results_file = argv[++i];
+        } else if (arg == "--max-nodes" && has_value) {
+            max_nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--min-nps" && has_value) {
+            min_nps = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (mode_name != "full" && mode_name != "bulk" && mode_name != "hash") {
+        usage();
+        return 1;
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    PerftMode mode = mode_name == "full" ? PERFT_FULL : PERFT_BULK;
+    std::unique_ptr<PerftTable> table;
+    if (mode_name == "hash") table = std::make_unique<PerftTable>(hash_mb);
+
+    std::vector<PerftEpd> suite;
+    if (epd_file.empty()) {
+        suite.push_back(PerftEpd{fen, {}});
+    } else {
+        std::ifstream in(epd_file);
+        if (!in) {
+            std::cerr << "cannot open " << epd_file << std::endl;
+            return 1;
+        }
+        std::string line;
+        PerftEpd entry;
+        while (std::getline(in, line)) {
+            if (parse_perft_epd(line, entry)) suite.push_back(entry);
+        }
+    }
+
+    std::ofstream results;
+    if (!results_file.empty()) {
+        results.open(results_file, std::ios::app);
+        if (!results) {
+            std::cerr << "cannot open " << results_file << std::endl;
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    for (const auto& entry : suite) {
+        Position pos;
+        std::string err;
+        if (!pos.set_from_fen(entry.fen, &err)) {
+            std::cerr << "bad FEN " << entry.fen << ": " << err << std::endl;
+            return 1;
+        }
+
+        // Deepest expectation within the requested depth and node budget; without any expectations, run
+        // unchecked at --depth
+        const std::pair<int, uint64_t>* check = nullptr;
+        for (const auto& e : entry.expected) {
+            if (e.first > depth || (max_nodes && e.second > max_nodes)) continue;
+            if (!check || e.first > check->first) check = &e;
+        }
+        if (!check && !entry.expected.empty()) {
+            std::cout << "{\"fen\":" << json_string(entry.fen) << ",\"depth\":" << depth
+                      << ",\"skipped\":true}" << std::endl;
+            continue;
+        }
+        int run_depth = check ? check->first : depth;
+        const uint64_t* expected = check ? &check->second : nullptr;
+
+        if (table) table->clear();
+        auto start = std::chrono::steady_clock::now();
+        PerftStats stats;
+        std::vector<PerftDivide> moves;
+        if (run_depth >= 2 && divide) {
+            moves = perft_divide(pos, run_depth, threads, mode, table.get());
+            for (const auto& m : moves) stats += m.stats;
+        } else {
+            // Below depth 2 the subtrees under the root moves do not carry the root moves' own stats
+            stats = perft_parallel(pos, run_depth, threads, mode, table.get());
+        }
+        auto end = std::chrono::steady_clock::now();
+        double secs = std::chrono::duration<double>(end - start).count();
+
+        // At depth 1 each root move is a single node; list them from the generator, outside the timing
+        if (run_depth == 1 && divide) {
+            for (const auto& m : MoveGenerator(pos).generate_legal()) {
+                PerftStats leaf;
+                leaf.nodes = 1;
+                moves.push_back(PerftDivide{m, leaf});
+            }
+        }
+
+        for (const auto& m : moves) {
+            std::ostringstream out;
+            out << "{\"fen\":" << json_string(entry.fen) << ",\"depth\":" << run_depth
+                << ",\"move\":\"" << move_to_uci(m.move) << "\",";
+            print_stats(out, m.stats, mode == PERFT_FULL);
+            out << "}";
+            std::cout << out.str() << "\n";
+        }
+
+        std::ostringstream out;
+        out << "{\"fen\":" << json_string(entry.fen) << ",\"depth\":" << run_depth << ",\"mode\":\""
+            << mode_name << "\",\"threads\":" << threads << ",";
+        print_stats(out, stats, mode == PERFT_FULL);
+        uint64_t nps = static_cast<uint64_t>(secs > 0 ? stats.nodes / secs : 0);
+        out << ",\"time_ms\":" << secs * 1000 << ",\"nps\":" << nps;
+        if (expected) {
+            bool ok = stats.nodes == *expected;
+            failures += !ok;
+            out << ",\"expected\":" << *expected << ",\"ok\":" << (ok ? "true" : "false");
+        }
+        // Shorter runs are dominated by thread start-up and timer noise
+        if (min_nps && stats.nodes >= 1000000) {
+            bool fast = nps >= min_nps;
+            failures += !fast;
+            out << ",\"min_nps\":" << min_nps << ",\"fast\":" << (fast ? "true" : "false");
+        }
+        out << "}";
+        std::cout << out.str() << std::endl;
+        if (results) results << out.str() << std::endl;
+    }
+    return failures ? 2 : 0;
+}
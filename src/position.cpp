@@ -1,5 +1,8 @@
 #include "position.hpp"
+#include "zobrist.hpp"
+#include "attacks.hpp"
 
+#include <cassert>
 #include <cctype>
 #include <sstream>
 
@@ -9,15 +12,30 @@ Position::Position() { clear(); }
 
 void Position::clear() {
   bitboards_.fill(0ULL);
+  board_.fill(NO_PIECE);
   side_ = WHITE;
   ep_square_ = -1;
   castling_ = 0;
   halfmove_ = 0;
   fullmove_ = 1;
+  key_ = compute_position_hash(*this);
 }
 
 static int file_rank_to_sq(int file, int rank) { return rank * 8 + file; }
 
+// Castling rights kept when a move touches a square: castling &= mask[from] & mask[to].
+// Only the king and rook home squares clear any bits (WK=1, WQ=2, BK=4, BQ=8).
+static constexpr int castling_rights_mask[64] = {
+  13, 15, 15, 15, 12, 15, 15, 14,
+  15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 15, 15, 15, 15,
+   7, 15, 15, 15,  3, 15, 15, 11
+};
+
 int Position::square_index(char file, char rank) {
   if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return -1;
   int f = file - 'a';
@@ -74,7 +92,7 @@ bool Position::set_from_fen(const std::string &fen, std::string *err) {
       }
       return false;
     }
-    bitboards_[piece] |= (1ULL << sq);
+    put_piece(piece, sq);
     ++sq;
   }
 
@@ -147,6 +165,7 @@ bool Position::set_from_fen(const std::string &fen, std::string *err) {
     }
   }
 
+  key_ = compute_position_hash(*this);
   return true;
 }
 
@@ -222,18 +241,52 @@ U64 Position::occupancy(Color c) const {
   return occ;
 }
 
-int Position::piece_on_square(int sq) const {
-  if (sq < 0 || sq > 63) return NO_PIECE;
-  U64 mask = 1ULL << sq;
-  for (int p = 0; p < 12; ++p) if (bitboards_[p] & mask) return p;
-  return NO_PIECE;
+U64 Position::attackers_to(int sq, U64 occ) const {
+  // Leaper tables are symmetric, so a piece on sq "attacks back" every piece of that kind that attacks it.
+  // Pawns are the exception: white pawns hitting sq stand where a black pawn on sq would capture.
+  U64 queens = bitboards_[WQ] | bitboards_[BQ];
+  return (pawn_attacks[BLACK][sq] & bitboards_[WP]) | (pawn_attacks[WHITE][sq] & bitboards_[BP]) |
+         (knight_attacks[sq] & (bitboards_[WN] | bitboards_[BN])) |
+         (king_attacks[sq] & (bitboards_[WK] | bitboards_[BK])) |
+         (bishop_attacks(sq, occ) & (bitboards_[WB] | bitboards_[BB] | queens)) |
+         (rook_attacks(sq, occ) & (bitboards_[WR] | bitboards_[BR] | queens));
+}
+
+void Position::put_piece(int piece, int sq) {
+  bitboards_[piece] |= (1ULL << sq);
+  board_[sq] = static_cast<int8_t>(piece);
+  key_ ^= zobrist::keys.piece[piece][sq];
+}
+
+void Position::remove_piece(int sq) {
+  int piece = board_[sq];
+  bitboards_[piece] &= ~(1ULL << sq);
+  board_[sq] = NO_PIECE;
+  key_ ^= zobrist::keys.piece[piece][sq];
+}
+
+void Position::move_piece(int from, int to) {
+  int piece = board_[from];
+  bitboards_[piece] ^= (1ULL << from) | (1ULL << to);
+  board_[from] = NO_PIECE;
+  board_[to] = static_cast<int8_t>(piece);
+  key_ ^= zobrist::keys.piece[piece][from] ^ zobrist::keys.piece[piece][to];
+}
+
+void Position::set_castling(int rights) {
+  key_ ^= zobrist::keys.castling[castling_] ^ zobrist::keys.castling[rights];
+  castling_ = rights;
+}
+
+void Position::verify_key() const {
+  assert(key_ == compute_position_hash(*this) && "incremental Zobrist key out of sync");
 }
 
 std::optional<Position::UnmoveInfo> Position::apply_move(int from, int to, int promo) {
   if (from < 0 || from > 63 || to < 0 || to > 63) return {};
 
-  int piece = piece_on_square(from);
-  int captured = piece_on_square(to);
+  int piece = board_[from];
+  int captured = board_[to];
   if (piece == NO_PIECE) return {};
 
   // Disallow moving opponent pieces
@@ -241,12 +294,7 @@ std::optional<Position::UnmoveInfo> Position::apply_move(int from, int to, int p
   bool is_white_piece = (piece >= WP && piece <= WK);
   if ((us == WHITE) != is_white_piece) return {};
 
-  UnmoveInfo info{from, to, promo, captured, castling_, ep_square_, halfmove_, false};
-
-  // Remove moving piece
-  bitboards_[piece] &= ~(1ULL << from);
-
-  // Place piece (with promotion if applicable)
+  // Validate promotion before touching the board
   int final_piece = piece;
   if (promo > 0) {
     // Pawn promotion
@@ -255,16 +303,24 @@ std::optional<Position::UnmoveInfo> Position::apply_move(int from, int to, int p
     int base = (us == WHITE) ? WN : BN;
     final_piece = base + promo - 1; // promo 1=N, 2=B, 3=R, 4=Q
   }
-  bitboards_[final_piece] |= (1ULL << to);
+
+  UnmoveInfo info{from, to, promo, captured, castling_, ep_square_, halfmove_, false, key_};
 
   // Remove captured piece
   if (captured != NO_PIECE) {
-    bitboards_[captured] &= ~(1ULL << to);
+    remove_piece(to);
     halfmove_ = 0;
   } else {
     ++halfmove_;
   }
 
+  // Move piece (with promotion if applicable)
+  move_piece(from, to);
+  if (final_piece != piece) {
+    remove_piece(to);
+    put_piece(final_piece, to);
+  }
+
   // Handle pawn double-push (en passant setup)
   ep_square_ = -1;
   if (piece == WP || piece == BP) {
@@ -276,54 +332,54 @@ std::optional<Position::UnmoveInfo> Position::apply_move(int from, int to, int p
       // En passant capture
       info.was_ep_capture = true;
       int ep_victim = (us == WHITE) ? (to - 8) : (to + 8);
-      bitboards_[piece_on_square(ep_victim)] &= ~(1ULL << ep_victim);
+      remove_piece(ep_victim);
     }
   }
 
   // Update castling rights
-  if (piece == WK) castling_ &= ~3;   // lose WK and WQ rights
-  if (piece == BK) castling_ &= ~12;  // lose BK and BQ rights
+  int castling = castling_;
+  if (piece == WK) castling &= ~3;   // lose WK and WQ rights
+  if (piece == BK) castling &= ~12;  // lose BK and BQ rights
   if (piece == WR) {
-    if (from == 0) castling_ &= ~2;   // a1
-    if (from == 7) castling_ &= ~1;   // h1
+    if (from == 0) castling &= ~2;   // a1
+    if (from == 7) castling &= ~1;   // h1
   }
   if (piece == BR) {
-    if (from == 56) castling_ &= ~8;  // a8
-    if (from == 63) castling_ &= ~4;  // h8
+    if (from == 56) castling &= ~8;  // a8
+    if (from == 63) castling &= ~4;  // h8
   }
   if (captured == WR) {
-    if (to == 0) castling_ &= ~2;
-    if (to == 7) castling_ &= ~1;
+    if (to == 0) castling &= ~2;
+    if (to == 7) castling &= ~1;
   }
   if (captured == BR) {
-    if (to == 56) castling_ &= ~8;
-    if (to == 63) castling_ &= ~4;
+    if (to == 56) castling &= ~8;
+    if (to == 63) castling &= ~4;
   }
+  set_castling(castling);
 
   // Handle castling move (special case)
   if (piece == WK && from == 4) {
     if (to == 6) { // King-side castling
-      bitboards_[WR] &= ~(1ULL << 7);
-      bitboards_[WR] |= (1ULL << 5);
+      move_piece(7, 5);
     } else if (to == 2) { // Queen-side castling
-      bitboards_[WR] &= ~1ULL;
-      bitboards_[WR] |= (1ULL << 3);
+      move_piece(0, 3);
     }
   }
   if (piece == BK && from == 60) {
     if (to == 62) { // King-side castling
-      bitboards_[BR] &= ~(1ULL << 63);
-      bitboards_[BR] |= (1ULL << 61);
+      move_piece(63, 61);
     } else if (to == 58) { // Queen-side castling
-      bitboards_[BR] &= ~(1ULL << 56);
-      bitboards_[BR] |= (1ULL << 59);
+      move_piece(56, 59);
     }
   }
 
   // Toggle side
   side_ = (side_ == WHITE) ? BLACK : WHITE;
+  key_ ^= zobrist::keys.side;
   if (side_ == WHITE) ++fullmove_;
 
+  verify_key();
   return info;
 }
 
@@ -331,11 +387,11 @@ void Position::undo_move(const UnmoveInfo &info) {
   side_ = (side_ == WHITE) ? BLACK : WHITE;
   if (side_ == BLACK) --fullmove_;
 
-  int piece = piece_on_square(info.to);
+  int piece = board_[info.to];
   if (piece == NO_PIECE) return; // Should not happen
 
   // Restore piece to original square
-  bitboards_[piece] &= ~(1ULL << info.to);
+  remove_piece(info.to);
   
   // Handle promotion: restore original pawn
   int restored_piece = piece;
@@ -343,11 +399,11 @@ void Position::undo_move(const UnmoveInfo &info) {
     Color us = side_;
     restored_piece = (us == WHITE) ? WP : BP;
   }
-  bitboards_[restored_piece] |= (1ULL << info.from);
+  put_piece(restored_piece, info.from);
 
   // Restore captured piece
   if (info.captured_piece != NO_PIECE) {
-    bitboards_[info.captured_piece] |= (1ULL << info.to);
+    put_piece(info.captured_piece, info.to);
   }
 
   // Restore state
@@ -358,20 +414,16 @@ void Position::undo_move(const UnmoveInfo &info) {
   // Undo castling rook moves (mirror of apply_move)
   if (restored_piece == WK && info.from == 4) {
     if (info.to == 6) {
-      bitboards_[WR] &= ~(1ULL << 5);
-      bitboards_[WR] |= (1ULL << 7);
+      move_piece(5, 7);
     } else if (info.to == 2) {
-      bitboards_[WR] &= ~(1ULL << 3);
-      bitboards_[WR] |= 1ULL;
+      move_piece(3, 0);
     }
   }
   if (restored_piece == BK && info.from == 60) {
     if (info.to == 62) {
-      bitboards_[BR] &= ~(1ULL << 61);
-      bitboards_[BR] |= (1ULL << 63);
+      move_piece(61, 63);
     } else if (info.to == 58) {
-      bitboards_[BR] &= ~(1ULL << 59);
-      bitboards_[BR] |= (1ULL << 56);
+      move_piece(59, 56);
     }
   }
 
@@ -379,9 +431,112 @@ void Position::undo_move(const UnmoveInfo &info) {
   if (info.was_ep_capture) {
     int ep_victim_sq = (restored_piece == WP) ? (info.to - 8) : (info.to + 8);
     int ep_victim = (restored_piece == WP) ? BP : WP;
-    bitboards_[ep_victim] |= (1ULL << ep_victim_sq);
+    put_piece(ep_victim, ep_victim_sq);
   }
+
+  // The piece helpers toggle key_ as they go; restoring the saved key is cheaper than undoing side and castling too.
+  key_ = info.old_key;
+  verify_key();
 }
 
-} // namespace chess
+void Position::do_move(Move m, StateInfo &st) {
+  if (side_ == WHITE) {
+    do_move_for<WHITE>(m, st);
+  } else {
+    do_move_for<BLACK>(m, st);
+  }
+}
+
+void Position::undo_move(Move m, const StateInfo &st) {
+  // side_ is the side to move after m, i.e. not the mover
+  if (side_ == WHITE) {
+    undo_move_for<BLACK>(m, st);
+  } else {
+    undo_move_for<WHITE>(m, st);
+  }
+}
+
+template <Color Us>
+void Position::do_move_for(Move m, StateInfo &st) {
+  st.key = key_;
+  st.halfmove = halfmove_;
+  st.captured = NO_PIECE;
+  st.castling = static_cast<int8_t>(castling_);
+  st.ep_square = static_cast<int8_t>(ep_square_);
+
+  int from = m.from();
+  int to = m.to();
+  int piece = board_[from];
 
+  ++halfmove_;
+  ep_square_ = -1;
+
+  if (m.is_capture()) {
+    // The en passant victim sits behind the target square, on the mover's side of it.
+    int cap_sq = m.is_en_passant() ? (to ^ 8) : to;
+    st.captured = board_[cap_sq];
+    remove_piece(cap_sq);
+    halfmove_ = 0;
+  }
+
+  move_piece(from, to);
+
+  if (piece == make_piece(Us, PAWN)) {
+    halfmove_ = 0;
+    if (m.is_double_push()) {
+      ep_square_ = (from + to) / 2;
+    } else if (m.is_promotion()) {
+      remove_piece(to);
+      put_piece(piece + m.promo(), to); // promo 1=N, 2=B, 3=R, 4=Q follows the pawn in Piece order
+    }
+  } else if (m.is_castle()) {
+    if (m.flags() == KING_CASTLE) {
+      move_piece(from + 3, from + 1);
+    } else {
+      move_piece(from - 4, from - 1);
+    }
+  }
+
+  set_castling(castling_ & castling_rights_mask[from] & castling_rights_mask[to]);
+
+  side_ = ~Us;
+  key_ ^= zobrist::keys.side;
+  if (Us == BLACK) ++fullmove_;
+
+  verify_key();
+}
+
+template <Color Us>
+void Position::undo_move_for(Move m, const StateInfo &st) {
+  side_ = Us;
+  if (Us == BLACK) --fullmove_;
+
+  int from = m.from();
+  int to = m.to();
+
+  if (m.is_promotion()) {
+    remove_piece(to);
+    put_piece(make_piece(Us, PAWN), to);
+  } else if (m.is_castle()) {
+    if (m.flags() == KING_CASTLE) {
+      move_piece(from + 1, from + 3);
+    } else {
+      move_piece(from - 1, from - 4);
+    }
+  }
+
+  move_piece(to, from);
+
+  if (st.captured != NO_PIECE) {
+    put_piece(st.captured, m.is_en_passant() ? (to ^ 8) : to);
+  }
+
+  castling_ = st.castling;
+  ep_square_ = st.ep_square;
+  halfmove_ = st.halfmove;
+  key_ = st.key;
+
+  verify_key();
+}
+
+} // namespace chess
@@ -0,0 +1,341 @@
+#include "position_batch.hpp"
+#include "bitboard_fill.hpp"
+#include <type_traits>
+
+namespace chess {
+
+namespace {
+
+using namespace fill;
+
+template <class V> FILL_INLINE U64 lane(const V &v, int j) {
+  if constexpr (std::is_same_v<V, U64>) return (void)j, v;
+  else return v[j];
+}
+
+// All ones in the lanes where x is non-zero
+template <class V> FILL_INLINE V nonzero(const V &x) {
+  if constexpr (std::is_same_v<V, U64>) return x ? ~0ULL : 0;
+  else return (V)(x != 0);
+}
+
+// Per-lane population count. Vectors use the SWAR reduction: AVX2 has no 64-bit popcount lane op.
+template <class V> FILL_INLINE V count(V x) {
+  if constexpr (std::is_same_v<V, U64>) {
+    return popcount(x);
+  } else {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = x + (x >> 8);
+    x = x + (x >> 16);
+    x = x + (x >> 32);
+    return x & 0x7F;
+  }
+}
+
+template <class V> FILL_INLINE V king_fill(const V &b) {
+  V row = b | (shift<1>(b) & ~FILE_A) | (shift<-1>(b) & ~FILE_H);
+  return (row | shift<8>(row) | shift<-8>(row)) & ~b;
+}
+
+// Look from our king along Dir: record a checking slider and the ray up to it, and return our piece
+// pinned on this ray, if any.
+template <int Dir, class V>
+FILL_INLINE V scan_ray(const V &king, const V &empty, const V &ours, const V &sliders, V &checkers, V &check_rays) {
+  V ray = occluded_fill<Dir>(king, empty);
+  V checker = ray & sliders;
+  checkers |= checker;
+  check_rays |= ray & nonzero(checker);
+  V blocker = ray & ours;
+  return blocker & nonzero(occluded_fill<Dir>(blocker, empty) & sliders);
+}
+
+// Slider moves along Dir, counted from the fill of all movers at once: rays in one direction from
+// different pieces never overlap, since each stops at the first occupied square.
+template <int Dir, class V>
+FILL_INLINE V slider_count(const V &movers, const V &empty, const V &targets) {
+  return count(occluded_fill<Dir>(movers, empty) & targets);
+}
+
+inline constexpr U64 G1 = 1ULL << 6, C1 = 1ULL << 2;
+inline constexpr U64 KING_SIDE_PATH = (1ULL << 5) | G1;
+inline constexpr U64 QUEEN_SIDE_PATH = (1ULL << 3) | C1;
+inline constexpr U64 QUEEN_SIDE_EMPTY = QUEEN_SIDE_PATH | (1ULL << 1);
+
+// One SIMD step: positions i .. i + lane_count<V> - 1, all with white to move
+template <class V, class Context>
+FILL_INLINE void analyze_step(const U64 *const *pieces, const U64 *castling, std::size_t i, int *counts,
+                               Context *ctx) {
+  V P = load<V>(pieces[PAWN] + i), N = load<V>(pieces[KNIGHT] + i), B = load<V>(pieces[BISHOP] + i);
+  V R = load<V>(pieces[ROOK] + i), Q = load<V>(pieces[QUEEN] + i), K = load<V>(pieces[KING] + i);
+  V p = load<V>(pieces[6 + PAWN] + i), n = load<V>(pieces[6 + KNIGHT] + i), b = load<V>(pieces[6 + BISHOP] + i);
+  V r = load<V>(pieces[6 + ROOK] + i), q = load<V>(pieces[6 + QUEEN] + i), k = load<V>(pieces[6 + KING] + i);
+  V ours = P | N | B | R | Q | K;
+  V theirs = p | n | b | r | q | k;
+  V empty = ~(ours | theirs);
+
+  // Squares the opponent attacks; its sliders look through our king so it cannot step back along a check
+  V their_diag = b | q, their_ortho = r | q, xray = empty | K;
+  V danger = (shift<-9>(p) & ~FILE_H) | (shift<-7>(p) & ~FILE_A) | knight_fill(n) | king_fill(k) |
+             occluded_fill<9>(their_diag, xray) | occluded_fill<7>(their_diag, xray) |
+             occluded_fill<-7>(their_diag, xray) | occluded_fill<-9>(their_diag, xray) |
+             occluded_fill<8>(their_ortho, xray) | occluded_fill<-8>(their_ortho, xray) |
+             occluded_fill<1>(their_ortho, xray) | occluded_fill<-1>(their_ortho, xray);
+
+  // Checkers, the squares that answer a single check, and pinned pieces by pin axis
+  V checkers = (((shift<7>(K) & ~FILE_H) | (shift<9>(K) & ~FILE_A)) & p) | (knight_fill(K) & n);
+  V check_rays = checkers;
+  V pin_file = scan_ray<8>(K, empty, ours, their_ortho, checkers, check_rays) |
+               scan_ray<-8>(K, empty, ours, their_ortho, checkers, check_rays);
+  V pin_rank = scan_ray<1>(K, empty, ours, their_ortho, checkers, check_rays) |
+               scan_ray<-1>(K, empty, ours, their_ortho, checkers, check_rays);
+  V pin_diag = scan_ray<9>(K, empty, ours, their_diag, checkers, check_rays) |
+               scan_ray<-9>(K, empty, ours, their_diag, checkers, check_rays);
+  V pin_anti = scan_ray<7>(K, empty, ours, their_diag, checkers, check_rays) |
+               scan_ray<-7>(K, empty, ours, their_diag, checkers, check_rays);
+  V pinned = pin_file | pin_rank | pin_diag | pin_anti;
+  V double_check = nonzero(checkers & (checkers - 1));
+  V no_check = ~nonzero(checkers);
+  V targets = ~ours & (check_rays | no_check) & ~double_check;
+
+  if (ctx) {
+    for (int j = 0; j < lane_count<V>; ++j) {
+      ctx[i + j] = Context{lane(targets, j), lane(pinned, j), lane(danger, j), lane(checkers, j)};
+    }
+  }
+  if (!counts) return;
+
+  // A pinned piece keeps only the moves along its pin axis
+  V free = ~pinned;
+  V diag = (B | Q) & (free | pin_diag), anti = (B | Q) & (free | pin_anti);
+  V file = (R | Q) & (free | pin_file), rank = (R | Q) & (free | pin_rank);
+  V total = slider_count<9>(diag, empty, targets) + slider_count<-9>(diag, empty, targets) +
+            slider_count<7>(anti, empty, targets) + slider_count<-7>(anti, empty, targets) +
+            slider_count<8>(file, empty, targets) + slider_count<-8>(file, empty, targets) +
+            slider_count<1>(rank, empty, targets) + slider_count<-1>(rank, empty, targets);
+
+  V knights = N & free;
+  total += count(jump<17>(knights) & targets) + count(jump<15>(knights) & targets) +
+           count(jump<10>(knights) & targets) + count(jump<6>(knights) & targets) +
+           count(jump<-6>(knights) & targets) + count(jump<-10>(knights) & targets) +
+           count(jump<-15>(knights) & targets) + count(jump<-17>(knights) & targets);
+
+  // Pawns: a move to the last rank counts four times, once per promotion piece
+  V single = shift<8>(P & (free | pin_file)) & empty;
+  V dbl = shift<8>(single & RANK_3) & empty & targets;
+  single &= targets;
+  V left = shift<7>(P & (free | pin_anti)) & ~FILE_H & theirs & targets;
+  V right = shift<9>(P & (free | pin_diag)) & ~FILE_A & theirs & targets;
+  total += count(single & ~RANK_8) + count(left & ~RANK_8) + count(right & ~RANK_8) + count(dbl) +
+           ((count(single & RANK_8) + count(left & RANK_8) + count(right & RANK_8)) << 2);
+
+  total += count(king_fill(K) & ~ours & ~danger);
+
+  // Castling: rights, empty squares up to the rook, and a king path the opponent does not attack
+  V rights = load<V>(castling + i) & no_check;
+  V king_side = rights & G1 & ~nonzero((~empty | danger) & KING_SIDE_PATH);
+  V queen_side = rights & C1 & ~nonzero((~empty & QUEEN_SIDE_EMPTY) | (danger & QUEEN_SIDE_PATH));
+  total += count(king_side | queen_side);
+
+  total &= nonzero(K);
+  for (int j = 0; j < lane_count<V>; ++j) counts[i + j] = static_cast<int>(lane(total, j));
+}
+
+template <class V, class Context>
+FILL_INLINE void analyze_lanes(const U64 *const *pieces, const U64 *castling, std::size_t n, int *counts,
+                                Context *ctx) {
+  for (std::size_t i = 0; i < n; i += lane_count<V>) analyze_step<V>(pieces, castling, i, counts, ctx);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+template <class Context>
+__attribute__((target("avx2"))) void analyze_avx2(const U64 *const *pieces, const U64 *castling, std::size_t n,
+                                                   int *counts, Context *ctx) {
+  analyze_lanes<U64x4>(pieces, castling, n, counts, ctx);
+}
+#endif
+
+// Serialize pawn moves of pawns that share one set of allowed destinations (white to move)
+void add_pawn_moves(MoveList &moves, U64 pawns, U64 allowed, U64 empty, U64 theirs, int flip) {
+  auto add = [&](U64 targets, int delta, int flags) {
+    for (; targets; targets &= targets - 1) {
+      int to = __builtin_ctzll(targets);
+      if ((1ULL << to) & RANK_8) {
+        for (int promo = 3; promo >= 0; --promo) {
+          moves.push_back(Move::make((to - delta) ^ flip, to ^ flip, (flags | PROMOTION) + promo));
+        }
+      } else {
+        moves.push_back(Move::make((to - delta) ^ flip, to ^ flip, flags));
+      }
+    }
+  };
+  U64 single = (pawns << 8) & empty;
+  add(((single & RANK_3) << 8) & empty & allowed, 16, DOUBLE_PUSH);
+  add(single & allowed, 8, QUIET);
+  add((pawns << 7) & ~FILE_H & theirs & allowed, 7, CAPTURE);
+  add((pawns << 9) & ~FILE_A & theirs & allowed, 9, CAPTURE);
+}
+
+} // namespace
+
+void PositionBatch::clear() {
+  for (auto &plane : pieces_) plane.clear();
+  castling_.clear();
+  ep_square_.clear();
+  mirrored_.clear();
+  size_ = 0;
+}
+
+void PositionBatch::reserve(std::size_t n) {
+  n = (n + LANES - 1) / LANES * LANES;
+  for (auto &plane : pieces_) plane.reserve(n);
+  castling_.reserve(n);
+  ep_square_.reserve(n);
+  mirrored_.reserve(n);
+}
+
+void PositionBatch::add(const Position &pos) {
+  // Grow a whole SIMD step at a time; unused lanes stay empty boards
+  if (size_ % LANES == 0) {
+    for (auto &plane : pieces_) plane.resize(size_ + LANES, 0);
+    castling_.resize(size_ + LANES, 0);
+    ep_square_.resize(size_ + LANES, -1);
+    mirrored_.resize(size_ + LANES, 0);
+  }
+
+  Color us = pos.side_to_move();
+  bool mirror = (us == BLACK);
+  auto view = [mirror](U64 b) { return mirror ? __builtin_bswap64(b) : b; };
+  for (int pt = PAWN; pt <= KING; ++pt) {
+    pieces_[pt][size_] = view(pos.bitboard(make_piece(us, static_cast<PieceType>(pt))));
+    pieces_[6 + pt][size_] = view(pos.bitboard(make_piece(~us, static_cast<PieceType>(pt))));
+  }
+  int rights = pos.castling_rights() >> (mirror ? 2 : 0);
+  castling_[size_] = ((rights & 1) ? G1 : 0) | ((rights & 2) ? C1 : 0);
+  int ep = pos.en_passant_square();
+  ep_square_[size_] = static_cast<int8_t>(ep < 0 ? -1 : (mirror ? ep ^ 56 : ep));
+  mirrored_[size_] = mirror;
+  ++size_;
+}
+
+void PositionBatch::analyze(int *counts, Context *ctx, FillKernel kernel) const {
+  const U64 *pieces[12];
+  for (int i = 0; i < 12; ++i) pieces[i] = pieces_[i].data();
+  std::size_t n = pieces_[0].size();
+
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (kernel == FILL_AVX2 && cpu_features().avx2) {
+    analyze_avx2(pieces, castling_.data(), n, counts, ctx);
+  } else if (kernel != FILL_SCALAR) {
+    analyze_lanes<U64x2>(pieces, castling_.data(), n, counts, ctx);
+  } else {
+    analyze_lanes<U64>(pieces, castling_.data(), n, counts, ctx);
+  }
+#else
+  (void)kernel;
+  analyze_lanes<U64>(pieces, castling_.data(), n, counts, ctx);
+#endif
+}
+
+int PositionBatch::en_passant_moves(std::size_t i, MoveList *moves) const {
+  int ep = ep_square_[i];
+  U64 king = pieces_[KING][i];
+  U64 victim = ep >= 0 ? 1ULL << (ep - 8) : 0;
+  if (!king || !(pieces_[6 + PAWN][i] & victim)) return 0;
+
+  int king_sq = __builtin_ctzll(king);
+  U64 occ = 0;
+  for (const auto &plane : pieces_) occ |= plane[i];
+  U64 their_diag = pieces_[6 + BISHOP][i] | pieces_[6 + QUEEN][i];
+  U64 their_ortho = pieces_[6 + ROOK][i] | pieces_[6 + QUEEN][i];
+  int flip = mirrored_[i] ? 56 : 0;
+
+  // Both pawns leave their squares at once, so test the king on the board after the capture
+  int found = 0;
+  for (U64 from = pawn_attacks[BLACK][ep] & pieces_[PAWN][i]; from; from &= from - 1) {
+    int from_sq = __builtin_ctzll(from);
+    U64 after = occ ^ (1ULL << from_sq) ^ (1ULL << ep) ^ victim;
+    U64 attackers = (pawn_attacks[WHITE][king_sq] & pieces_[6 + PAWN][i] & ~victim) |
+                    (knight_attacks[king_sq] & pieces_[6 + KNIGHT][i]) |
+                    (bishop_attacks(king_sq, after) & their_diag) | (rook_attacks(king_sq, after) & their_ortho);
+    if (attackers) continue;
+    ++found;
+    if (moves) moves->push_back(Move::make(from_sq ^ flip, ep ^ flip, EP_CAPTURE));
+  }
+  return found;
+}
+
+void PositionBatch::count_legal_moves(std::vector<int> &counts, FillKernel kernel) const {
+  counts.assign(pieces_[0].size(), 0);
+  analyze(counts.data(), static_cast<Context *>(nullptr), kernel);
+  counts.resize(size_);
+  for (std::size_t i = 0; i < size_; ++i) {
+    if (ep_square_[i] >= 0) counts[i] += en_passant_moves(i, nullptr);
+  }
+}
+
+void PositionBatch::generate_legal(std::vector<MoveList> &moves, FillKernel kernel) const {
+  std::vector<Context> ctx(pieces_[0].size());
+  analyze(nullptr, ctx.data(), kernel);
+  moves.resize(size_);
+
+  for (std::size_t i = 0; i < size_; ++i) {
+    MoveList &list = moves[i];
+    list.clear();
+    U64 king = pieces_[KING][i];
+    if (!king) continue;
+
+    const Context &c = ctx[i];
+    int king_sq = __builtin_ctzll(king);
+    int flip = mirrored_[i] ? 56 : 0;
+    U64 ours = 0, theirs = 0;
+    for (int pt = PAWN; pt <= KING; ++pt) {
+      ours |= pieces_[pt][i];
+      theirs |= pieces_[6 + pt][i];
+    }
+    U64 occ = ours | theirs;
+    auto add_all = [&](int from, U64 to_set) {
+      for (; to_set; to_set &= to_set - 1) {
+        int to = __builtin_ctzll(to_set);
+        list.push_back(Move::make(from ^ flip, to ^ flip, (theirs & (1ULL << to)) ? CAPTURE : QUIET));
+      }
+    };
+
+    // Double check leaves no target for anything but the king
+    if (c.targets) {
+      add_pawn_moves(list, pieces_[PAWN][i] & ~c.pinned, c.targets, ~occ, theirs, flip);
+      for (U64 b = pieces_[PAWN][i] & c.pinned; b; b &= b - 1) {
+        int from = __builtin_ctzll(b);
+        add_pawn_moves(list, 1ULL << from, c.targets & line_bb[king_sq][from], ~occ, theirs, flip);
+      }
+      for (U64 b = pieces_[KNIGHT][i] & ~c.pinned; b; b &= b - 1) {
+        int from = __builtin_ctzll(b);
+        add_all(from, knight_attacks[from] & c.targets);
+      }
+      for (int pt = BISHOP; pt <= QUEEN; ++pt) {
+        for (U64 b = pieces_[pt][i]; b; b &= b - 1) {
+          int from = __builtin_ctzll(b);
+          U64 att = pt == BISHOP ? bishop_attacks(from, occ) : pt == ROOK ? rook_attacks(from, occ)
+                                                              : queen_attacks(from, occ);
+          U64 allowed = (c.pinned & (1ULL << from)) ? c.targets & line_bb[king_sq][from] : c.targets;
+          add_all(from, att & allowed);
+        }
+      }
+      en_passant_moves(i, &list);
+    }
+    add_all(king_sq, king_attacks[king_sq] & ~ours & ~c.danger);
+
+    if (!c.checkers) {
+      U64 rights = castling_[i];
+      if ((rights & G1) && !((occ | c.danger) & KING_SIDE_PATH)) {
+        list.push_back(Move::make(4 ^ flip, 6 ^ flip, KING_CASTLE));
+      }
+      if ((rights & C1) && !(occ & QUEEN_SIDE_EMPTY) && !(c.danger & QUEEN_SIDE_PATH)) {
+        list.push_back(Move::make(4 ^ flip, 2 ^ flip, QUEEN_CASTLE));
+      }
+    }
+  }
+}
+
+} // namespace chess
@@ -10,7 +10,7 @@ MoveEvaluation RandomEngine::get_best_move(const Position& position, int depth,
     (void)movetime_ms;
     Position pos_copy = position;  // Copy for move legality checking
     auto legal_moves = chess::get_legal_moves(pos_copy);
-    if (legal_moves.empty()) return MoveEvaluation{Move(-1, -1, 0), 0}; // Invalid move if no legal moves
+    if (legal_moves.empty()) return MoveEvaluation{Move(), 0}; // Invalid move if no legal moves
     
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -0,0 +1,91 @@
+#include "see.hpp"
+#include "attacks.hpp"
+#include <algorithm>
+
+namespace chess {
+
+namespace {
+
+// Value gained on the target square by the move itself, and the value of the piece then standing there.
+void initial_exchange(const Position &pos, Move m, int &gain, int &on_square) {
+  int mover = piece_type(static_cast<Piece>(pos.piece_on_square(m.from())));
+  gain = 0;
+  if (m.is_en_passant()) {
+    gain = see_value[PAWN];
+  } else if (m.is_capture()) {
+    gain = see_value[piece_type(static_cast<Piece>(pos.piece_on_square(m.to())))];
+  }
+  on_square = see_value[mover];
+  if (m.is_promotion()) {
+    on_square = see_value[m.promo()]; // promo 1..4 = N, B, R, Q, matching PieceType
+    gain += on_square - see_value[PAWN];
+  }
+}
+
+} // namespace
+
+int see(const Position &pos, Move m) {
+  if (m.is_castle()) return 0;
+
+  int from = m.from();
+  int to = m.to();
+  int gain[32];
+  int next_victim;
+  initial_exchange(pos, m, gain[0], next_victim);
+
+  U64 occ = pos.occupied() ^ (1ULL << from);
+  if (m.is_en_passant()) occ ^= 1ULL << (to ^ 8);
+
+  U64 diagonal = pos.bitboard(WB) | pos.bitboard(BB) | pos.bitboard(WQ) | pos.bitboard(BQ);
+  U64 straight = pos.bitboard(WR) | pos.bitboard(BR) | pos.bitboard(WQ) | pos.bitboard(BQ);
+  U64 attackers = pos.attackers_to(to, occ) & occ;
+  Color side = static_cast<Color>(pos.side_to_move() ^ 1);
+
+  int d = 0;
+  while (true) {
+    U64 ours = attackers & pos.occupancy(side);
+    if (!ours) break;
+
+    // Least valuable attacker
+    int pt = PAWN;
+    U64 bb = 0;
+    for (; pt <= KING; ++pt) {
+      bb = ours & pos.bitboard(make_piece(side, static_cast<PieceType>(pt)));
+      if (bb) break;
+    }
+    // The king may only capture last: with an enemy attacker left, the capture would be illegal
+    if (pt == KING && (attackers & pos.occupancy(static_cast<Color>(side ^ 1)))) break;
+
+    ++d;
+    gain[d] = next_victim - gain[d - 1];
+    next_victim = see_value[pt];
+
+    // Remove the attacker and uncover any slider behind it on the same line
+    occ ^= bb & (0 - bb);
+    if (pt == PAWN || pt == BISHOP || pt == QUEEN) attackers |= bishop_attacks(to, occ) & diagonal;
+    if (pt == ROOK || pt == QUEEN) attackers |= rook_attacks(to, occ) & straight;
+    attackers &= occ;
+    side = static_cast<Color>(side ^ 1);
+  }
+
+  while (d > 0) {
+    gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    --d;
+  }
+  return gain[0];
+}
+
+bool see_ge(const Position &pos, Move m, int threshold) {
+  if (m.is_castle()) return threshold <= 0;
+  if (!m.is_promotion()) {
+    int gain, on_square;
+    initial_exchange(pos, m, gain, on_square);
+    // Even keeping the captured piece for free does not reach the threshold
+    if (gain < threshold) return false;
+    // Even losing the moved piece for nothing in return still reaches it
+    if (gain - on_square >= threshold) return true;
+  }
+  return see(pos, m) >= threshold;
+}
+
+} // namespace chess
@@ -4,6 +4,7 @@
 #include "pv_engine.hpp"
 #include "material_engine.hpp"
 #include "move_notation.hpp"
+#include "cpu.hpp"
 #include <iostream>
 #include <sstream>
 #include <chrono>
@@ -72,6 +73,7 @@ void UCI::run() {
 void UCI::handle_uci() {
     std::cout << "id name " << uci_engine_->name() << std::endl;
     std::cout << "id author Michael" << std::endl;
+    std::cout << "info string kernels " << cpu_kernel_summary() << std::endl;
     std::cout << "option name Hash type spin default 32 min 1 max 4096" << std::endl;
     std::cout << "option name Threads type spin default 1 min 1 max 128" << std::endl;
     std::cout << "uciok" << std::endl;
@@ -119,7 +121,7 @@ void UCI::handle_position(const std::string& line) {
             auto move = uci_to_move(move_str);
             if (move) {
                 // UCI must apply moves regardless of player type.
-                game_->apply_move(move->from, move->to, move->promo);
+                game_->apply_move(move->from(), move->to(), move->promo());
             }
         }
     }
@@ -340,7 +342,7 @@ void UCI::search_thread(int depth, long long movetime_ms) {
     std::cout.flush();
 
     // Send best move
-    std::cout << "bestmove " << square_to_uci(best_eval.move.from, best_eval.move.to, best_eval.move.promo);
+    std::cout << "bestmove " << square_to_uci(best_eval.move.from(), best_eval.move.to(), best_eval.move.promo());
     std::cout << std::endl;
     std::cout.flush();
 }
@@ -0,0 +1,53 @@
+// Measures wall time from launching a UCI engine process until it answers "uciok".
+// Usage: chess_uci_startup_bench [runs] [engine_path...]
+// Defaults to 20 runs of each configured engine binary.
+#include "uci_client.hpp"
+#include "config.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace chess;
+
+int main(int argc, char* argv[]) {
+    int runs = 20;
+    std::vector<std::string> engines;
+    if (argc > 1) {
+        runs = std::max(1, std::atoi(argv[1]));
+    }
+    for (int i = 2; i < argc; ++i) {
+        engines.push_back(argv[i]);
+    }
+    if (engines.empty()) {
+        engines = {WHITE_ENGINE_BIN_PATH, BLACK_ENGINE_BIN_PATH};
+    }
+
+    // UIClient logs its handshake to stderr; keep the report on stdout readable
+    std::freopen("/dev/null", "w", stderr);
+
+    for (const auto& path : engines) {
+        std::vector<double> samples;
+        for (int i = 0; i < runs; ++i) {
+            UIClient client(path);
+            auto start = std::chrono::steady_clock::now();
+            bool ok = client.initialize();
+            auto end = std::chrono::steady_clock::now();
+            if (!ok) {
+                std::cout << path << ": engine failed to start" << std::endl;
+                return 1;
+            }
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            client.quit();
+        }
+
+        std::sort(samples.begin(), samples.end());
+        std::cout << path << ": start->uciok over " << runs << " runs: min "
+                  << samples.front() << " ms, median " << samples[samples.size() / 2]
+                  << " ms, max " << samples.back() << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -1,17 +1,18 @@
 #include <catch2/catch_test_macros.hpp>
 #include "position.hpp"
 #include "search.hpp"
+#include "perft.hpp"
 #include "attacks.hpp"
+#include "attack_info.hpp"
+#include "zobrist.hpp"
+#include "movegen.hpp"
+#include "movepick.hpp"
+#include "see.hpp"
+#include "position_batch.hpp"
+#include <algorithm>
 
 using namespace chess;
 
-// Initialize attack tables before running tests using RAII
-static struct Initializer {
-  Initializer() { 
-    AttackTablesInitializer init;
-  }
-} initializer;
-
 // Test perft on initial position
 TEST_CASE("perft initial position depth 1-4", "[perft]") {
   Position pos;
@@ -102,6 +103,386 @@ TEST_CASE("perft position 4 depth 1-4", "[perft]") {
   }
 }
 
+TEST_CASE("bulk-counting perft matches the full node counts", "[perft]") {
+  Position pos;
+  struct Case { const char *fen; int depth; uint64_t nodes; };
+  const Case cases[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 4, 4085603},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333}
+  };
+  for (const auto &c : cases) {
+    REQUIRE(pos.set_from_fen(c.fen));
+    for (int depth = 0; depth <= c.depth; ++depth) {
+      REQUIRE(perft_bulk(pos, depth) == perft(pos, depth).nodes);
+    }
+    REQUIRE(perft(pos, c.depth, PERFT_BULK).nodes == c.nodes);
+  }
+}
+
+static void require_same_stats(const PerftStats &a, const PerftStats &b) {
+  REQUIRE(a.nodes == b.nodes);
+  REQUIRE(a.captures == b.captures);
+  REQUIRE(a.en_passants == b.en_passants);
+  REQUIRE(a.castles == b.castles);
+  REQUIRE(a.promotions == b.promotions);
+  REQUIRE(a.checks == b.checks);
+  REQUIRE(a.checkmates == b.checkmates);
+}
+
+TEST_CASE("perft stats policies fill only the requested fields", "[perft]") {
+  Position pos;
+  REQUIRE(pos.set_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"));
+  for (int depth = 1; depth <= 3; ++depth) {
+    PerftStats full = perft<PerftFull>(pos, depth);
+    require_same_stats(full, perft(pos, depth));
+
+    PerftStats some = perft<PerftCounters<PERFT_CAPTURES | PERFT_CASTLES | PERFT_CHECKMATES>>(pos, depth);
+    PerftStats expected;
+    expected.nodes = full.nodes;
+    expected.captures = full.captures;
+    expected.castles = full.castles;
+    expected.checkmates = full.checkmates;
+    require_same_stats(some, expected);
+  }
+}
+
+TEST_CASE("parallel perft matches serial perft", "[perft]") {
+  Position pos;
+  const char *fens[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+  };
+  for (const char *fen : fens) {
+    REQUIRE(pos.set_from_fen(fen));
+    for (int depth = 1; depth <= 4; ++depth) {
+      PerftStats serial = perft(pos, depth);
+      for (int threads : {1, 3, 4}) {
+        require_same_stats(perft_parallel(pos, depth, threads), serial);
+        REQUIRE(perft_parallel(pos, depth, threads, PERFT_BULK).nodes == serial.nodes);
+      }
+    }
+    // Each divide entry is the subtree below its root move
+    for (const auto &entry : perft_divide(pos, 3, 4)) {
+      StateInfo st;
+      pos.do_move(entry.move, st);
+      require_same_stats(entry.stats, perft(pos, 2));
+      pos.undo_move(entry.move, st);
+    }
+  }
+}
+
+TEST_CASE("hash-table perft matches the known totals", "[perft]") {
+  Position pos;
+  struct Case { const char *fen; int depth; uint64_t nodes; };
+  const Case cases[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 4, 4085603},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333}
+  };
+  // A small table, so entries are replaced and collide on slots along the way
+  PerftTable table(1);
+  for (const auto &c : cases) {
+    REQUIRE(pos.set_from_fen(c.fen));
+    REQUIRE(perft_hashed(pos, c.depth, table) == c.nodes);
+    REQUIRE(perft_hashed(pos, c.depth, table) == c.nodes); // now answered from the table
+    table.clear();
+    REQUIRE(perft_parallel(pos, c.depth, 4, PERFT_BULK, &table).nodes == c.nodes);
+    table.clear();
+  }
+}
+
+// Walk the move tree and compare the incremental Zobrist key against a full recompute at every node.
+// Also checks that the search fast path (do_move) and the checked apply_move reach the same position.
+static void check_keys(Position &pos, int depth) {
+  REQUIRE(pos.key() == compute_position_hash(pos));
+  if (depth == 0) return;
+  for (const auto &m : get_legal_moves(pos)) {
+    uint64_t before = pos.key();
+    auto fen_before = pos.get_fen();
+
+    StateInfo st;
+    pos.do_move(m, st);
+    uint64_t fast_key = pos.key();
+    auto fast_fen = pos.get_fen();
+    pos.undo_move(m, st);
+    REQUIRE(pos.key() == before);
+    REQUIRE(pos.get_fen() == fen_before);
+
+    auto info = pos.apply_move(m.from(), m.to(), m.promo());
+    REQUIRE(info);
+    REQUIRE(pos.key() == fast_key);
+    REQUIRE(pos.get_fen() == fast_fen);
+    check_keys(pos, depth - 1);
+    pos.undo_move(*info);
+    REQUIRE(pos.key() == before);
+  }
+}
+
+TEST_CASE("incremental zobrist key matches full recompute", "[zobrist]") {
+  Position pos;
+  const char *fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+  };
+  for (const char *fen : fens) {
+    REQUIRE(pos.set_from_fen(fen));
+    check_keys(pos, 3);
+  }
+}
+
+// Compare the pin/check-aware legal generator against make/test/unmake filtering of pseudo-legal moves.
+static void check_legal_moves(Position &pos, int depth) {
+  Color us = pos.side_to_move();
+  MoveGenerator gen(pos);
+  MoveList filtered;
+  for (const auto &m : gen.generate_pseudo_legal()) {
+    if (m.is_castle() && !is_castling_legal(pos, m.from(), m.to())) continue;
+    StateInfo st;
+    pos.do_move(m, st);
+    if (!is_in_check(pos, us)) filtered.push_back(m);
+    pos.undo_move(m, st);
+  }
+  MoveList legal = gen.generate_legal();
+  REQUIRE(legal.size() == filtered.size());
+  REQUIRE(gen.has_legal_move() == !legal.empty());
+  for (const auto &m : filtered) {
+    REQUIRE(std::find(legal.begin(), legal.end(), m) != legal.end());
+  }
+  if (depth == 0) return;
+  for (const auto &m : legal) {
+    StateInfo st;
+    pos.do_move(m, st);
+    check_legal_moves(pos, depth - 1);
+    pos.undo_move(m, st);
+  }
+}
+
+TEST_CASE("legal generator matches pseudo-legal filtering", "[movegen]") {
+  Position pos;
+  const char *fens[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "8/8/8/K2pP2r/8/8/8/7k w - d6 0 1", // en passant would expose the king along the rank
+    "R6k/6pp/8/8/8/8/8/K7 b - - 0 1",   // checkmate
+    "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"    // stalemate
+  };
+  for (const char *fen : fens) {
+    REQUIRE(pos.set_from_fen(fen));
+    check_legal_moves(pos, 2);
+  }
+}
+
+static bool contains(const MoveList &moves, Move m) {
+  return std::find(moves.begin(), moves.end(), m) != moves.end();
+}
+
+// Staged generation must partition the legal moves, and the picker must hand out each exactly once.
+// gives_check must agree with making the move and looking.
+static void check_stages(Position &pos, int depth) {
+  MoveGenerator gen(pos);
+  MoveList legal = gen.generate<LEGAL>();
+  MoveList captures = gen.generate<CAPTURES>();
+  MoveList quiets = gen.generate<QUIETS>();
+  MoveList quiet_checks = gen.generate<QUIET_CHECKS>();
+  Color us = pos.side_to_move();
+  Color them = static_cast<Color>(us ^ 1);
+
+  REQUIRE(captures.size() + quiets.size() == legal.size());
+  for (const auto &m : captures) REQUIRE((contains(legal, m) && (m.is_capture() || m.is_promotion())));
+  CheckInfo ci(pos);
+  for (const auto &m : legal) {
+    StateInfo st;
+    pos.do_move(m, st);
+    bool check = is_in_check(pos, them);
+    pos.undo_move(m, st);
+    REQUIRE(gives_check(pos, ci, m) == check);
+    if (contains(quiets, m)) REQUIRE(contains(quiet_checks, m) == (check && !m.is_castle()));
+  }
+  REQUIRE(quiet_checks.size() <= quiets.size());
+  if (is_in_check(pos, us)) REQUIRE(gen.generate<EVASIONS>().size() == legal.size());
+
+  Move hash_move = legal.empty() ? Move() : legal[legal.size() / 2];
+  MovePicker picker(pos, hash_move);
+  MoveList picked;
+  for (Move m = picker.next_move(); m != Move(); m = picker.next_move()) {
+    REQUIRE_FALSE(contains(picked, m));
+    picked.push_back(m);
+  }
+  REQUIRE(picked.size() == legal.size());
+  if (!legal.empty()) REQUIRE(picked[0] == hash_move);
+
+  if (depth == 0) return;
+  for (const auto &m : legal) {
+    StateInfo st;
+    pos.do_move(m, st);
+    check_stages(pos, depth - 1);
+    pos.undo_move(m, st);
+  }
+}
+
+TEST_CASE("staged generation and move picker cover the legal moves", "[movegen]") {
+  Position pos;
+  const char *fens[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+  };
+  for (const char *fen : fens) {
+    REQUIRE(pos.set_from_fen(fen));
+    check_stages(pos, 2);
+  }
+}
+
+// The set-wise attack maps must equal the union of per-square table lookups, for every fill kernel.
+static void check_attack_maps(Position &pos, int depth) {
+  AttackInfo expected;
+  for (int c = 0; c < 2; ++c) {
+    Color color = static_cast<Color>(c);
+    U64 occ = pos.occupied() ^ pos.bitboard(make_piece(~color, KING));
+    for (int pt = PAWN; pt <= KING; ++pt) {
+      for (U64 b = pos.bitboard(make_piece(color, static_cast<PieceType>(pt))); b; b &= b - 1) {
+        int sq = __builtin_ctzll(b);
+        U64 att = pt == PAWN ? pawn_attacks[c][sq] : pt == KNIGHT ? knight_attacks[sq]
+                : pt == BISHOP ? bishop_attacks(sq, occ) : pt == ROOK ? rook_attacks(sq, occ)
+                : pt == QUEEN ? queen_attacks(sq, occ) : king_attacks[sq];
+        expected.by_type[c][pt] |= att;
+        expected.all[c] |= att;
+      }
+    }
+  }
+  for (FillKernel kernel : {FILL_SCALAR, FILL_SSE2, FILL_AVX2}) {
+    AttackInfo info;
+    compute_attack_info(pos, info, kernel);
+    for (int c = 0; c < 2; ++c) {
+      for (int pt = PAWN; pt <= KING; ++pt) REQUIRE(info.by_type[c][pt] == expected.by_type[c][pt]);
+      REQUIRE(info.all[c] == expected.all[c]);
+    }
+  }
+  REQUIRE(attack_info(pos).all[WHITE] == expected.all[WHITE]);
+  if (depth == 0) return;
+  for (const auto &m : get_legal_moves(pos)) {
+    StateInfo st;
+    pos.do_move(m, st);
+    check_attack_maps(pos, depth - 1);
+    pos.undo_move(m, st);
+  }
+}
+
+TEST_CASE("attack maps match per-square lookups", "[attacks]") {
+  Position pos;
+  const char *fens[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+  };
+  for (const char *fen : fens) {
+    REQUIRE(pos.set_from_fen(fen));
+    check_attack_maps(pos, 2);
+  }
+}
+
+static void collect_positions(Position &pos, int depth, std::vector<Position> &out) {
+  out.push_back(pos);
+  if (depth == 0) return;
+  for (const auto &m : get_legal_moves(pos)) {
+    StateInfo st;
+    pos.do_move(m, st);
+    collect_positions(pos, depth - 1, out);
+    pos.undo_move(m, st);
+  }
+}
+
+TEST_CASE("batched move generation matches the move generator", "[movegen]") {
+  const char *fens[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "8/8/8/K2pP2r/8/8/8/7k w - d6 0 1",
+    "R6k/6pp/8/8/8/8/8/K7 b - - 0 1"
+  };
+  std::vector<Position> positions;
+  for (const char *fen : fens) {
+    Position pos;
+    REQUIRE(pos.set_from_fen(fen));
+    collect_positions(pos, 2, positions);
+  }
+  PositionBatch batch;
+  for (const auto &pos : positions) batch.add(pos);
+  REQUIRE(batch.size() == positions.size());
+
+  std::vector<MoveList> expected;
+  for (const auto &pos : positions) expected.push_back(MoveGenerator(pos).generate_legal());
+  for (FillKernel kernel : {FILL_SCALAR, FILL_SSE2, FILL_AVX2}) {
+    std::vector<int> counts;
+    std::vector<MoveList> moves;
+    batch.count_legal_moves(counts, kernel);
+    batch.generate_legal(moves, kernel);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      REQUIRE(counts[i] == expected[i].size());
+      REQUIRE(moves[i].size() == expected[i].size());
+      for (const auto &m : moves[i]) {
+        const Move *found = std::find(expected[i].begin(), expected[i].end(), m);
+        REQUIRE(found != expected[i].end());
+        REQUIRE(found->flags() == m.flags());
+      }
+    }
+  }
+}
+
+TEST_CASE("static exchange evaluation", "[see]") {
+  Position pos;
+  // Undefended pawn
+  REQUIRE(pos.set_from_fen("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1"));
+  REQUIRE(see(pos, Move::make(4, 36, CAPTURE)) == 100);
+  // Queen takes a pawn-defended pawn
+  REQUIRE(pos.set_from_fen("4k3/8/3p4/4p3/8/8/8/4QK2 w - - 0 1"));
+  REQUIRE(see(pos, Move::make(4, 36, CAPTURE)) == -800);
+  REQUIRE_FALSE(see_ge(pos, Move::make(4, 36, CAPTURE), 0));
+  // Doubled rooks: the rear rook joins by x-ray, but the exchange still costs a rook for two pawns
+  REQUIRE(pos.set_from_fen("4k3/8/3p4/4p3/8/8/4R3/4RK2 w - - 0 1"));
+  REQUIRE(see(pos, Move::make(12, 36, CAPTURE)) == -300);
+  // Knight takes a rook defended only by a pawn: wins the exchange
+  REQUIRE(pos.set_from_fen("4k3/8/3p4/4r3/8/5N2/8/4K3 w - - 0 1"));
+  REQUIRE(see(pos, Move::make(21, 36, CAPTURE)) == 180);
+  REQUIRE(see_ge(pos, Move::make(21, 36, CAPTURE), 180));
+  REQUIRE_FALSE(see_ge(pos, Move::make(21, 36, CAPTURE), 181));
+  // Same, with a bishop behind the knight that wins the recapturing pawn back
+  REQUIRE(pos.set_from_fen("4k3/8/3p4/4r3/8/5N2/1B6/4K3 w - - 0 1"));
+  REQUIRE(see(pos, Move::make(21, 36, CAPTURE)) == 280);
+  REQUIRE(see_ge(pos, Move::make(21, 36, CAPTURE), 280));
+  REQUIRE_FALSE(see_ge(pos, Move::make(21, 36, CAPTURE), 281));
+  // The king cannot recapture on a square the opponent still attacks
+  REQUIRE(pos.set_from_fen("3r4/8/8/8/8/5k2/4q3/3QK3 b - - 0 1"));
+  REQUIRE(see(pos, Move::make(12, 3, CAPTURE)) == 900);
+}
+
+TEST_CASE("packed move keeps from/to/promo and flags", "[move]") {
+  REQUIRE(sizeof(Move) == 2);
+  for (int from = 0; from < 64; ++from) {
+    for (int to = 0; to < 64; ++to) {
+      for (int promo = 0; promo <= 4; ++promo) {
+        Move m(from, to, promo);
+        REQUIRE(m.from() == from);
+        REQUIRE(m.to() == to);
+        REQUIRE(m.promo() == promo);
+      }
+    }
+  }
+  // Flags never take part in equality, so UCI-parsed moves match generated ones.
+  REQUIRE(Move::make(12, 28, DOUBLE_PUSH) == Move(12, 28));
+  REQUIRE(Move::make(52, 61, PROMO_CAPTURE | 3) == Move(52, 61, 4));
+  REQUIRE(Move::make(52, 61, PROMO_CAPTURE | 3).is_capture());
+  REQUIRE(Move::make(36, 43, EP_CAPTURE).is_en_passant());
+  REQUIRE(Move::make(36, 43, EP_CAPTURE).is_capture());
+  REQUIRE(Move::make(4, 6, KING_CASTLE).is_castle());
+  REQUIRE_FALSE(Move(52, 60, 1) == Move(52, 60, 2));
+}
+
 // TEST_CASE("perft by move breakdown", "[perft]") {
 //   Position pos;
 //   for (int depth = 1; depth <= 5; ++depth) {